@@ -0,0 +1,243 @@
+#include "ticket_map_trace.hpp"
+#include "columnar_ticket_map.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace {
+    /// The values stored in the maps the trace is replayed against
+    using payload=
+        std::tuple<std::uint64_t, std::uint64_t, std::uint64_t, std::uint64_t>;
+
+    /// The number of times each configuration is replayed; the fastest run
+    /// is kept, to reduce the noise from other activity on the machine
+    constexpr unsigned repetitions= 3;
+
+    /// The measurements for one configuration
+    struct result {
+        /// A short description of the configuration
+        std::string name;
+        /// The map type for the configuration, in terms of Ticket and Value
+        std::string type;
+        /// The throughput in millions of operations per second
+        double mops= 0;
+        /// The 99th percentile latency over all operations, in nanoseconds
+        std::uint64_t p99= 0;
+        /// The peak memory used by the map's storage, in bytes
+        std::size_t bytes= 0;
+        /// Whether no other configuration is at least as good in every
+        /// respect and better in one
+        bool optimal= false;
+    };
+
+    /// Returns true if a is at least as good as b in every respect, and
+    /// better in at least one
+    bool dominates(result const &a, result const &b) {
+        return a.mops >= b.mops && a.p99 <= b.p99 && a.bytes <= b.bytes &&
+               (a.mops > b.mops || a.p99 < b.p99 || a.bytes < b.bytes);
+    }
+
+    /// Replay the trace against a map of type Map, and measure it. Each slot
+    /// of the map's storage takes slot_bytes bytes.
+    template <typename Map>
+    result evaluate(
+        std::string name, std::string type, std::size_t slot_bytes,
+        std::string const &trace) {
+        result best{std::move(name), std::move(type)};
+        for(unsigned i= 0; i != repetitions; ++i) {
+            std::istringstream in(trace);
+            Map map;
+            auto const statistics= jss::replay_trace(in, map);
+            auto const mops=
+                statistics.operations() * 1e3 / std::max<std::uint64_t>(
+                                                    statistics.elapsed, 1);
+            if(mops <= best.mops)
+                continue;
+            jss::latency_histogram all;
+            for(auto const &latency : statistics.latency) {
+                all.merge(latency);
+            }
+            best.mops= mops;
+            best.p99= all.percentile(99);
+            best.bytes= statistics.peak_capacity * slot_bytes;
+        }
+        return best;
+    }
+
+    /// Return the policy for a compaction threshold and growth factor, as it
+    /// would be written in code, or an empty string for the default policy
+    std::string policy_name(
+        std::size_t threshold_num, std::size_t threshold_den,
+        std::size_t growth_num, std::size_t growth_den) {
+        std::string policy;
+        if(growth_num != 2 * growth_den)
+            policy= "jss::growth_factor_policy<" +
+                    std::to_string(growth_num) + ", " +
+                    std::to_string(growth_den) + ">";
+        if(threshold_num * 2 != threshold_den)
+            policy= "jss::compaction_threshold_policy<" +
+                    std::to_string(threshold_num) + ", " +
+                    std::to_string(threshold_den) +
+                    (policy.empty() ? "" : ", " + policy) + ">";
+        return policy;
+    }
+
+    /// Evaluate a ticket_map with the specified compaction threshold and
+    /// growth factor
+    template <
+        std::size_t ThresholdNum, std::size_t ThresholdDen,
+        std::size_t GrowthNum, std::size_t GrowthDen>
+    void evaluate_policy(
+        std::vector<result> &results, std::string const &trace) {
+        using policy= jss::compaction_threshold_policy<
+            ThresholdNum, ThresholdDen,
+            jss::growth_factor_policy<GrowthNum, GrowthDen>>;
+        using map_type= jss::ticket_map<std::uint64_t, payload, policy>;
+        using slot_type=
+            std::pair<std::uint64_t, std::optional<payload>>;
+
+        auto const name= policy_name(
+            ThresholdNum, ThresholdDen, GrowthNum, GrowthDen);
+        results.push_back(evaluate<map_type>(
+            "rows compact<" + std::to_string(ThresholdNum) + "/" +
+                std::to_string(ThresholdDen) + " grow*" +
+                std::to_string(GrowthNum) + "/" + std::to_string(GrowthDen),
+            "jss::ticket_map<Ticket, Value" +
+                (name.empty() ? "" : ", " + name) + ">",
+            sizeof(slot_type), trace));
+    }
+
+    /// Evaluate a ticket_map for each growth factor, with the specified
+    /// compaction threshold
+    template <std::size_t ThresholdNum, std::size_t ThresholdDen>
+    void evaluate_growth_factors(
+        std::vector<result> &results, std::string const &trace) {
+        evaluate_policy<ThresholdNum, ThresholdDen, 3, 2>(results, trace);
+        evaluate_policy<ThresholdNum, ThresholdDen, 2, 1>(results, trace);
+        evaluate_policy<ThresholdNum, ThresholdDen, 4, 1>(results, trace);
+    }
+
+    /// Evaluate every configuration in the matrix
+    std::vector<result> evaluate_all(std::string const &trace) {
+        std::vector<result> results;
+        evaluate_growth_factors<1, 4>(results, trace);
+        evaluate_growth_factors<1, 2>(results, trace);
+        evaluate_growth_factors<3, 4>(results, trace);
+        results.push_back(
+            evaluate<jss::columnar_ticket_map<std::uint64_t, payload>>(
+                "columns", "jss::columnar_ticket_map<Ticket, Value>",
+                sizeof(std::uint64_t) + sizeof(unsigned char) +
+                    4 * sizeof(std::uint64_t),
+                trace));
+
+        for(auto &candidate : results) {
+            candidate.optimal= std::none_of(
+                results.begin(), results.end(), [&](result const &other) {
+                    return dominates(other, candidate);
+                });
+        }
+        return results;
+    }
+
+    /// Print the usage message
+    void usage(char const *program) {
+        std::fprintf(
+            stderr,
+            "Usage: %s [trace-file]\n"
+            "       %s [--live N] [--operations N] [--lookups N]\n",
+            program, program);
+    }
+
+    /// Read the trace from the file named by the arguments, or record one
+    /// from the workload they describe. Returns false if the arguments are
+    /// invalid or the file can't be read.
+    bool load_trace(int argc, char **argv, std::string &trace) {
+        if(argc == 2 && argv[1][0] != '-') {
+            std::ifstream file(argv[1], std::ios::binary);
+            if(!file) {
+                std::fprintf(stderr, "Cannot open %s\n", argv[1]);
+                return false;
+            }
+            std::ostringstream contents;
+            contents << file.rdbuf();
+            trace= contents.str();
+            return true;
+        }
+
+        jss::workload_spec spec;
+        for(int i= 1; i < argc; i+= 2) {
+            if(i + 1 == argc) {
+                usage(argv[0]);
+                return false;
+            }
+            auto const value= std::strtoull(argv[i + 1], nullptr, 10);
+            if(!std::strcmp(argv[i], "--live"))
+                spec.live= value;
+            else if(!std::strcmp(argv[i], "--operations"))
+                spec.operations= value;
+            else if(!std::strcmp(argv[i], "--lookups"))
+                spec.lookups= value;
+            else {
+                usage(argv[0]);
+                return false;
+            }
+        }
+        std::printf(
+            "Replaying a synthetic workload: %zu live elements, %zu "
+            "inserts and erases, %zu lookups each\n",
+            spec.live, spec.operations, spec.lookups);
+        std::ostringstream synthetic;
+        jss::record_workload(synthetic, spec);
+        trace= synthetic.str();
+        return true;
+    }
+} // namespace
+
+int main(int argc, char **argv) {
+    std::string trace;
+    if(!load_trace(argc, argv, trace))
+        return 1;
+
+    std::vector<result> results;
+    try {
+        results= evaluate_all(trace);
+    } catch(std::exception &e) {
+        std::fprintf(stderr, "Replay failed: %s\n", e.what());
+        return 1;
+    }
+
+    std::printf(
+        "%-28s %10s %10s %12s %s\n", "configuration", "Mops/s", "p99 ns",
+        "peak KiB", "pareto");
+    for(auto const &candidate : results) {
+        std::printf(
+            "%-28s %10.3f %10llu %12zu %s\n", candidate.name.c_str(),
+            candidate.mops, static_cast<unsigned long long>(candidate.p99),
+            candidate.bytes / 1024, candidate.optimal ? "*" : "");
+    }
+
+    std::printf("\nPareto-optimal configurations:\n");
+    result const *recommended= nullptr;
+    for(auto const &candidate : results) {
+        if(!candidate.optimal)
+            continue;
+        std::printf("  %s\n", candidate.type.c_str());
+        if(!recommended || candidate.mops > recommended->mops)
+            recommended= &candidate;
+    }
+
+    std::printf(
+        "\nRecommended, for the highest throughput on the Pareto front:\n\n"
+        "template <typename Ticket, typename Value>\n"
+        "using tuned_ticket_map= %s;\n",
+        recommended->type.c_str());
+}
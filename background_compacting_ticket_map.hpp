@@ -0,0 +1,342 @@
+// This code is released under the Boost Software License
+// https://www.boost.org/LICENSE_1_0.txt
+// (C) Copyright 2021 Anthony Williams
+
+#pragma once
+
+#include "ticket_map.hpp"
+#include <cstdlib>
+#include <algorithm>
+#include <atomic>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace jss {
+
+    namespace detail {
+        /// The policy for the storage of a background_compacting_ticket_map,
+        /// which leaves compaction to the background thread and never
+        /// shrinks the storage, so erasing in the foreground never moves the
+        /// other elements
+        template <typename Policy>
+        struct background_storage_policy : deferred_compaction_policy<Policy> {
+            /// Never shrink
+            constexpr std::size_t
+            shrink_capacity(std::size_t, std::size_t capacity) const noexcept {
+                return capacity;
+            }
+        };
+
+        /// Implements the operations on the storage of a ticket_map needed by
+        /// background_compacting_ticket_map
+        struct ticket_map_background_access {
+            /// The type of the storage of Map
+            template <typename Map> using storage_type=
+                typename Map::collection_type;
+
+            /// Returns a copy of the live elements of map, with room for
+            /// capacity elements. Calls none of the policy's hooks, so the
+            /// copy can be made on another thread, provided the map isn't
+            /// modified meanwhile.
+            template <typename Map>
+            static storage_type<Map>
+            copy_live(Map const &map, std::size_t capacity) {
+                storage_type<Map> storage;
+                storage.reserve(std::max(capacity, map.size()));
+                for(auto const &entry : map.data) {
+                    if(entry.second)
+                        storage.emplace_back(entry.first, entry.second);
+                }
+                return storage;
+            }
+
+            /// Returns the index of the slot holding the element with the
+            /// specified ticket, or nullopt if there is no such element.
+            /// Calls none of the policy's hooks.
+            template <typename Map, typename Ticket>
+            static std::optional<std::size_t>
+            find_slot(Map const &map, Ticket const &ticket) noexcept {
+                auto const iter= Map::lookup(map.data, ticket);
+                if(iter == map.data.end())
+                    return std::nullopt;
+                return static_cast<std::size_t>(iter - map.data.begin());
+            }
+
+            /// Erase the element with the specified ticket from map, if there
+            /// is one, without looking for the next element or compacting, so
+            /// the time taken doesn't depend on the number of empty slots.
+            /// Returns true if there was such an element, false otherwise.
+            template <typename Map, typename Ticket>
+            static bool erase(Map &map, Ticket const &ticket) noexcept {
+                [[maybe_unused]] auto const timer=
+                    map.mapPolicy.start_timer(ticket_map_operation::erase);
+                auto const iter= Map::lookup(map.data, ticket);
+                if(iter == map.data.end())
+                    return false;
+                map.erase_slot(iter);
+                return true;
+            }
+
+            /// Swap the storage of map with storage, which must hold the same
+            /// elements and no empty slots, and tell the map's policy. The
+            /// map must have no reservations, and must not be tracking order
+            /// statistics.
+            template <typename Map>
+            static void
+            swap_storage(Map &map, storage_type<Map> &storage) noexcept {
+                map.data.swap(storage);
+                map.filledItems= map.data.size();
+                map.storage_changed();
+            }
+        };
+    } // namespace detail
+
+    /// A ticket_map that compacts its storage on a background thread, so
+    /// erasing an element never has to wait for the other elements to be
+    /// moved, however big the map is.
+    ///
+    /// When enough of the storage is empty, as determined by
+    /// Policy::needs_compaction, a background thread builds a compacted copy
+    /// of the storage, without calling any of the policy's hooks. Meanwhile,
+    /// the storage is left untouched: erased tickets are recorded in a side
+    /// log, and new elements are inserted into a separate tail map. The next
+    /// operation after the copy is complete swaps it in, reporting the change
+    /// to the policy's on_storage_changed hook, erases the logged tickets from
+    /// it, and moves the tail elements into it. The old storage is destroyed
+    /// by the background thread at the start of the next compaction, so it
+    /// stays allocated until then. The storage is never shrunk in the
+    /// foreground, even if Policy says so; the compacted copy only has room
+    /// for twice the live elements.
+    ///
+    /// Value must be copy-constructible. The map itself must only be used
+    /// from one thread at a time.
+    template <
+        typename Ticket, typename Value,
+        typename Policy= default_ticket_map_policy>
+    class background_compacting_ticket_map {
+        static_assert(
+            std::is_copy_constructible_v<Value>,
+            "Value must be copy constructible");
+
+        /// The underlying map type, which leaves compaction to us
+        using map_type= ticket_map<
+            Ticket, Value, detail::background_storage_policy<Policy>>;
+
+        /// The storage of the underlying map
+        using storage_type=
+            detail::ticket_map_background_access::storage_type<map_type>;
+
+    public:
+        /// Construct an empty map
+        background_compacting_ticket_map()= default;
+
+        /// Construct an empty map with the specified policy
+        explicit background_compacting_ticket_map(Policy policy) :
+            main(detail::background_storage_policy<Policy>{
+                {std::move(policy)}}) {}
+
+        background_compacting_ticket_map(
+            background_compacting_ticket_map const &)= delete;
+        background_compacting_ticket_map &
+        operator=(background_compacting_ticket_map const &)= delete;
+
+        /// Destroy the map, waiting for any background compaction to finish
+        ~background_compacting_ticket_map() {
+            if(worker.joinable())
+                worker.join();
+        }
+
+        /// Insert a new value into the map. It is assigned a new ticket value.
+        /// Returns the ticket for the new entry.
+        /// Throws overflow_error if the Ticket values have overflowed.
+        Ticket insert(Value v) {
+            poll();
+            if(overflow)
+                throw std::overflow_error(
+                    "Ticket values overflowed; cannot insert");
+            auto &target= compacting() ? tail : main;
+            target.insert_with_ticket(nextId, std::move(v));
+            return detail::increment_with_overflow_check(nextId, overflow);
+        }
+
+        /// Insert a new value into the map, constructed from args. It is
+        /// assigned a new ticket value. Returns the ticket for the new entry.
+        /// Throws overflow_error if the Ticket values have overflowed.
+        template <typename... Args> Ticket emplace(Args &&... args) {
+            return insert(Value(std::forward<Args>(args)...));
+        }
+
+        /// Remove the element with the specified ticket. Returns true if there
+        /// was such an element, false otherwise. Never compacts the storage,
+        /// or scans it for the next element, in the calling thread, so the
+        /// time taken doesn't grow with the number of empty slots, but may
+        /// start a background compaction.
+        bool erase(Ticket const &ticket) {
+            poll();
+            if(!compacting()) {
+                if(!detail::ticket_map_background_access::erase(main, ticket))
+                    return false;
+                auto const &policy= static_cast<Policy const &>(
+                    main.get_policy());
+                if(policy.needs_compaction(main.size(), main.tickets().size()))
+                    compact();
+                return true;
+            }
+            if(detail::ticket_map_background_access::erase(tail, ticket))
+                return true;
+            auto const slot=
+                detail::ticket_map_background_access::find_slot(main, ticket);
+            if(!slot || erasedSlots[*slot])
+                return false;
+            erasedSlots[*slot]= true;
+            erasedLog.push_back(ticket);
+            return true;
+        }
+
+        /// Find a value in the map by its ticket. Returns a pointer to the
+        /// value, or nullptr if there is no element with that ticket. The
+        /// value may be being copied by the background thread, so cannot be
+        /// modified through the map.
+        Value const *find(Ticket const &ticket) {
+            poll();
+            if(compacting()) {
+                if(auto iter= tail.find(ticket); iter != tail.end())
+                    return &iter->value;
+                auto const slot=
+                    detail::ticket_map_background_access::find_slot(
+                        main, ticket);
+                if(slot && erasedSlots[*slot])
+                    return nullptr;
+            }
+            auto const &storage= main;
+            auto iter= storage.find(ticket);
+            return iter != storage.end() ? &iter->value : nullptr;
+        }
+
+        /// Returns 1 if there is an element with the specified ticket, 0
+        /// otherwise
+        std::size_t count(Ticket const &ticket) {
+            return find(ticket) ? 1 : 0;
+        }
+
+        /// Returns the number of elements in the map
+        std::size_t size() const noexcept {
+            return main.size() - erasedLog.size() + tail.size();
+        }
+
+        /// Returns true if there are no elements in the map, false otherwise
+        bool empty() const noexcept {
+            return size() == 0;
+        }
+
+        /// Returns the number of elements the main storage has room for
+        std::size_t capacity() const noexcept {
+            return main.capacity();
+        }
+
+        /// Returns true if a background compaction is in progress, false
+        /// otherwise
+        bool compacting() const noexcept {
+            return inProgress;
+        }
+
+        /// Start compacting the storage on a background thread, unless a
+        /// compaction is already in progress
+        void compact() {
+            if(compacting())
+                return;
+            erasedSlots.assign(main.tickets().size(), false);
+            done.store(false, std::memory_order_relaxed);
+            worker= std::thread([this] { build_compacted(); });
+            inProgress= true;
+        }
+
+        /// Wait for any background compaction to finish, and swap in the
+        /// compacted storage
+        void wait() {
+            if(compacting())
+                finish_compaction();
+        }
+
+    private:
+        /// Swap in the compacted storage if the background compaction has
+        /// finished
+        void poll() {
+            if(compacting() && done.load(std::memory_order_acquire))
+                finish_compaction();
+        }
+
+        /// Build the compacted copy of the storage. Runs on the background
+        /// thread, so must not call any of the policy's hooks. If the copy
+        /// cannot be built, the storage is left uncompacted.
+        void build_compacted() noexcept {
+            try {
+                storage_type().swap(compacted);
+                compacted= detail::ticket_map_background_access::copy_live(
+                    main, main.size() * 2);
+                succeeded= true;
+            } catch(...) {
+                succeeded= false;
+            }
+            done.store(true, std::memory_order_release);
+        }
+
+        /// Wait for the background thread, swap in the compacted storage, and
+        /// apply the side log and the tail to it
+        void finish_compaction() {
+            if(worker.joinable())
+                worker.join();
+            if(succeeded)
+                detail::ticket_map_background_access::swap_storage(
+                    main, compacted);
+            if(main.insert_capacity() < tail.size())
+                main.reserve(main.size() + tail.size());
+            std::sort(erasedLog.begin(), erasedLog.end());
+            {
+                auto batch= main.batch();
+                for(auto const &ticket : erasedLog) {
+                    batch.erase(ticket);
+                }
+            }
+            erasedLog.clear();
+            erasedSlots.clear();
+            for(auto &entry : tail) {
+                main.insert_with_ticket(entry.ticket, std::move(entry.value));
+            }
+            tail.clear();
+            inProgress= false;
+        }
+
+        /// The next ticket to issue
+        Ticket nextId{};
+        /// Set once the tickets have overflowed
+        bool overflow= false;
+        /// The main storage, which is left untouched by the foreground while
+        /// a background compaction is in progress
+        map_type main;
+        /// Elements inserted while a background compaction is in progress
+        map_type tail;
+        /// The compacted copy of the storage of main built by the background
+        /// thread, and then the old storage once it has been swapped in
+        storage_type compacted;
+        /// The tickets of elements in main erased while a background
+        /// compaction is in progress, in the order they were erased
+        std::vector<Ticket> erasedLog;
+        /// Which slots of main hold elements erased while a background
+        /// compaction is in progress
+        std::vector<bool> erasedSlots;
+        /// The background thread
+        std::thread worker;
+        /// Set by the background thread when it has finished
+        std::atomic<bool> done{false};
+        /// Set by the background thread if it built the copy successfully
+        bool succeeded= false;
+        /// Set while a background compaction is in progress, until its result
+        /// has been swapped in
+        bool inProgress= false;
+    };
+} // namespace jss
@@ -0,0 +1,298 @@
+#include "ticket_map.hpp"
+#include "columnar_ticket_map.hpp"
+#include "perf_counters.hpp"
+#include "memory_usage.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <optional>
+#include <random>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+    /// The values stored in the maps
+    using payload= std::tuple<std::uint64_t, std::uint64_t, std::uint32_t>;
+
+    /// Stops the compiler optimizing away the benchmarked operations
+    volatile std::uint64_t sink;
+
+    /// The results of measuring one operation
+    struct measurement {
+        /// The elapsed time in nanoseconds
+        double nanoseconds;
+        /// The hardware counter values
+        jss::perf_counters::sample counts;
+    };
+
+    /// Run f once, measuring the time taken and the hardware counters
+    template <typename F>
+    measurement measure(jss::perf_counters &counters, F f) {
+        auto const start= std::chrono::steady_clock::now();
+        counters.start();
+        f();
+        counters.stop();
+        auto const finish= std::chrono::steady_clock::now();
+        return {std::chrono::duration<double, std::nano>(finish - start)
+                    .count(),
+                counters.read()};
+    }
+
+    /// Print the header for the results table
+    void print_header(jss::perf_counters const &counters) {
+        if(!counters.any_available())
+            std::printf(
+                "Hardware performance counters are unavailable; "
+                "reporting times only\n");
+        std::printf("%-10s %-8s %10s", "layout", "op", "ns/op");
+        for(std::size_t i= 0; i != jss::perf_counters::counter_count; ++i) {
+            std::printf(
+                " %12s",
+                jss::perf_counters::name(
+                    static_cast<jss::perf_counters::counter>(i)));
+        }
+        std::printf(" %6s\n", "IPC");
+    }
+
+    /// Print the per-operation results for one operation on one layout
+    void print_result(
+        char const *layout, char const *op, std::size_t ops,
+        measurement const &result) {
+        std::printf("%-10s %-8s %10.2f", layout, op, result.nanoseconds / ops);
+        for(auto const &count : result.counts) {
+            if(count)
+                std::printf(" %12.3f", *count / ops);
+            else
+                std::printf(" %12s", "-");
+        }
+        auto const &cycles= result.counts[jss::perf_counters::cycles];
+        auto const &instructions=
+            result.counts[jss::perf_counters::instructions];
+        if(cycles && instructions && *cycles)
+            std::printf(" %6.2f\n", *instructions / *cycles);
+        else
+            std::printf(" %6s\n", "-");
+    }
+
+    /// Benchmark insert, lookup, iteration and erase for one layout. first
+    /// extracts the first field from a value in the map.
+    template <typename Map, typename First>
+    void benchmark_layout(
+        char const *layout, std::size_t count,
+        std::vector<unsigned> const &shuffled, jss::perf_counters &counters,
+        First first) {
+        Map map;
+
+        print_result(layout, "insert", count, measure(counters, [&] {
+                         for(std::size_t i= 0; i != count; ++i) {
+                             map.insert(payload(i, i * 2, 0));
+                         }
+                     }));
+
+        print_result(layout, "lookup", count, measure(counters, [&] {
+                         std::uint64_t sum= 0;
+                         for(auto ticket : shuffled) {
+                             sum+= first(map.find(ticket)->value);
+                         }
+                         sink= sum;
+                     }));
+
+        print_result(layout, "iterate", count, measure(counters, [&] {
+                         std::uint64_t sum= 0;
+                         for(auto const &entry : map) {
+                             sum+= first(entry.value);
+                         }
+                         sink= sum;
+                     }));
+
+        print_result(layout, "erase", count, measure(counters, [&] {
+                         for(auto ticket : shuffled) {
+                             map.erase(ticket);
+                         }
+                     }));
+    }
+
+    /// The maximum number of bytes of values and tickets stored in each map
+    /// when measuring memory, to keep the large value sizes manageable
+    constexpr std::size_t memory_payload_limit= std::size_t(64) << 20;
+
+    /// The memory in use by the process at one point
+    struct memory_reading {
+        /// The bytes allocated from the heap, if known
+        std::optional<std::size_t> heap;
+        /// The bytes resident in RAM, if known
+        std::optional<std::size_t> resident;
+    };
+
+    /// Read the memory in use, having returned freed memory to the operating
+    /// system so the resident size only covers memory actually in use
+    memory_reading read_memory() {
+        jss::process_memory::release_free_memory();
+        return {
+            jss::process_memory::heap_bytes(),
+            jss::process_memory::resident_bytes()};
+    }
+
+    /// Print the header for the memory results table
+    void print_memory_header() {
+        std::printf(
+            "%-10s %6s %6s %10s %12s %12s %10s\n", "layout", "value", "holes",
+            "live", "heap B/live", "RSS B/live", "heap/data");
+    }
+
+    /// Print the bytes per live entry for the change from before to after,
+    /// or "-" if unknown
+    void print_per_entry(
+        std::optional<std::size_t> before, std::optional<std::size_t> after,
+        std::size_t live) {
+        if(before && after && live)
+            std::printf(
+                " %12.1f",
+                (static_cast<double>(*after) - static_cast<double>(*before)) /
+                    live);
+        else
+            std::printf(" %12s", "-");
+    }
+
+    /// Measure the memory used by a Map holding count entries with values of
+    /// value_size bytes, of which holes percent have been erased. The
+    /// erased entries are spread evenly through the tickets. insert adds the
+    /// entry with the specified ticket.
+    template <typename Map, typename Insert>
+    void measure_memory(
+        char const *layout, std::size_t value_size, std::size_t count,
+        unsigned holes, Insert insert) {
+        auto const before= read_memory();
+        memory_reading after;
+        std::size_t live= 0;
+        {
+            Map map;
+            for(std::uint64_t ticket= 0; ticket != count; ++ticket) {
+                insert(map, ticket);
+            }
+            for(std::uint64_t ticket= 0; ticket != count; ++ticket) {
+                if(ticket % 10 < holes / 10)
+                    map.erase(ticket);
+                else
+                    ++live;
+            }
+            after= read_memory();
+        }
+        std::printf(
+            "%-10s %6zu %5u%% %10zu", layout, value_size, holes, live);
+        print_per_entry(before.heap, after.heap, live);
+        print_per_entry(before.resident, after.resident, live);
+        if(before.heap && after.heap && live)
+            std::printf(
+                " %9.2fx\n",
+                (static_cast<double>(*after.heap) -
+                 static_cast<double>(*before.heap)) /
+                    (live * (value_size + sizeof(std::uint64_t))));
+        else
+            std::printf(" %10s\n", "-");
+    }
+
+    /// Returns a value of N bytes for the specified ticket
+    template <std::size_t N> std::array<char, N> make_value(std::uint64_t i) {
+        std::array<char, N> value{};
+        value[0]= static_cast<char>(i);
+        return value;
+    }
+
+    /// Measure the memory used by each layout for values of N bytes, at
+    /// hole ratios from 0 to 90%
+    template <std::size_t N> void benchmark_memory(std::size_t count) {
+        using value= std::array<char, N>;
+        count= std::min(
+            count, memory_payload_limit / (N + sizeof(std::uint64_t)));
+        auto const insert_value= [](auto &map, std::uint64_t ticket) {
+            map.insert(make_value<N>(ticket));
+        };
+        auto const insert_row= [](auto &map, std::uint64_t ticket) {
+            map.insert(std::tuple(make_value<N>(ticket)));
+        };
+        auto const insert_pair= [](auto &map, std::uint64_t ticket) {
+            map.emplace(ticket, make_value<N>(ticket));
+        };
+        for(unsigned holes= 0; holes != 100; holes+= 10) {
+            measure_memory<jss::ticket_map<std::uint64_t, value>>(
+                "ticket_map", N, count, holes, insert_value);
+        }
+        for(unsigned holes= 0; holes != 100; holes+= 10) {
+            measure_memory<jss::ticket_map<
+                std::uint64_t, value, jss::deferred_compaction_policy<>>>(
+                "deferred", N, count, holes, insert_value);
+        }
+        for(unsigned holes= 0; holes != 100; holes+= 10) {
+            measure_memory<jss::ticket_map<
+                std::uint64_t, value, jss::release_memory_policy<>>>(
+                "release", N, count, holes, insert_value);
+        }
+        for(unsigned holes= 0; holes != 100; holes+= 10) {
+            measure_memory<
+                jss::columnar_ticket_map<std::uint64_t, std::tuple<value>>>(
+                "columnar", N, count, holes, insert_row);
+        }
+        for(unsigned holes= 0; holes != 100; holes+= 10) {
+            measure_memory<std::map<std::uint64_t, value>>(
+                "std::map", N, count, holes, insert_pair);
+        }
+        for(unsigned holes= 0; holes != 100; holes+= 10) {
+            measure_memory<std::unordered_map<std::uint64_t, value>>(
+                "unordered", N, count, holes, insert_pair);
+        }
+    }
+
+    /// Measure the memory used by each layout for each value size
+    void benchmark_memory(std::size_t count) {
+        if(!jss::process_memory::heap_bytes())
+            std::printf(
+                "The allocator can't report heap usage; "
+                "reporting resident memory only\n");
+        std::printf(
+            "Up to %zu entries, bytes are per live entry, heap/data is heap "
+            "bytes over value and ticket bytes\n",
+            count);
+        print_memory_header();
+        benchmark_memory<1>(count);
+        benchmark_memory<8>(count);
+        benchmark_memory<64>(count);
+        benchmark_memory<512>(count);
+        benchmark_memory<4096>(count);
+    }
+} // namespace
+
+int main(int argc, char **argv) {
+    if(argc > 1 && !std::strcmp(argv[1], "memory")) {
+        benchmark_memory(
+            argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1000000);
+        return 0;
+    }
+
+    std::size_t const count=
+        argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+
+    std::vector<unsigned> shuffled(count);
+    for(std::size_t i= 0; i != count; ++i) {
+        shuffled[i]= static_cast<unsigned>(i);
+    }
+    std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(42));
+
+    jss::perf_counters counters;
+    std::printf("%zu elements, counts are per operation\n", count);
+    print_header(counters);
+
+    benchmark_layout<jss::ticket_map<unsigned, payload>>(
+        "ticket_map", count, shuffled, counters,
+        [](auto const &value) { return std::get<0>(value); });
+    benchmark_layout<jss::columnar_ticket_map<unsigned, payload>>(
+        "columnar", count, shuffled, counters,
+        [](auto const &value) { return value.template get<0>(); });
+}
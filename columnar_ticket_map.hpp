@@ -0,0 +1,769 @@
+// This code is released under the Boost Software License
+// https://www.boost.org/LICENSE_1_0.txt
+// (C) Copyright 2021 Anthony Williams
+
+#pragma once
+
+#include "ticket_map.hpp"
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <iterator>
+#include <optional>
+
+namespace jss {
+
+    /// Describes the fields of a tuple-like Value type, such as std::tuple or
+    /// a struct with tuple_size, tuple_element and get specializations.
+    template <typename Value> struct tuple_fields {
+        /// The type described
+        using value_type= Value;
+
+        /// The number of fields
+        static constexpr std::size_t count= std::tuple_size_v<Value>;
+
+        /// The type of field I
+        template <std::size_t I> using type= std::tuple_element_t<I, Value>;
+
+        /// Access field I of a value
+        template <std::size_t I, typename V>
+        static constexpr decltype(auto) get(V &&value) noexcept {
+            using std::get;
+            return get<I>(std::forward<V>(value));
+        }
+
+        /// Construct a value from its fields
+        template <typename... Fields>
+        static constexpr Value make(Fields &&... fields) {
+            return Value{std::forward<Fields>(fields)...};
+        }
+    };
+
+    /// Describes the fields of a struct by a list of pointers to its data
+    /// members, e.g. member_fields<&S::x,&S::y>. The struct must be
+    /// default-constructible.
+    template <auto... Members> struct member_fields {
+        static_assert(
+            sizeof...(Members) > 0, "There must be at least one field");
+
+    private:
+        template <typename> struct member_traits;
+
+        template <typename Class, typename Field>
+        struct member_traits<Field Class::*> {
+            using class_type= Class;
+            using field_type= Field;
+        };
+
+        using members_type= std::tuple<decltype(Members)...>;
+
+        /// The pointer to member for field I
+        template <std::size_t I>
+        static constexpr std::tuple_element_t<I, members_type> member=
+            std::get<I>(members_type(Members...));
+
+    public:
+        /// The type described
+        using value_type= typename member_traits<
+            std::tuple_element_t<0, members_type>>::class_type;
+
+        /// The number of fields
+        static constexpr std::size_t count= sizeof...(Members);
+
+        /// The type of field I
+        template <std::size_t I>
+        using type= typename member_traits<
+            std::tuple_element_t<I, members_type>>::field_type;
+
+        /// Access field I of a value
+        template <std::size_t I, typename V>
+        static constexpr decltype(auto) get(V &&value) noexcept {
+            return (std::forward<V>(value).*member<I>);
+        }
+
+        /// Construct a value from its fields
+        template <typename... Fields>
+        static value_type make(Fields &&... fields) {
+            value_type value;
+            ((value.*Members= std::forward<Fields>(fields)), ...);
+            return value;
+        }
+    };
+
+    /// A ticket map that stores each field of Value in a separate array,
+    /// sharing a single array of tickets. Loops that only access one field
+    /// touch only the memory for that field.
+    ///
+    /// Fields describes how to split Value into fields; see tuple_fields and
+    /// member_fields. Each field must be default-constructible and
+    /// move-assignable: the fields of erased elements are reset to
+    /// default-constructed values until the storage is compacted.
+    ///
+    /// Ticket has the same requirements as for ticket_map.
+    template <
+        typename Ticket, typename Value, typename Fields= tuple_fields<Value>>
+    class columnar_ticket_map {
+        static_assert(
+            std::is_default_constructible<Ticket>(),
+            "Ticket must be default constructible");
+        static_assert(
+            std::is_same_v<
+                decltype(std::declval<Ticket &>() < std::declval<Ticket &>()),
+                bool>,
+            "Ticket must be less-than-comparable");
+        static_assert(
+            std::is_same_v<typename Fields::value_type, Value>,
+            "Fields must describe Value");
+
+        /// The indices of the fields
+        using field_indices= std::make_index_sequence<Fields::count>;
+
+        template <typename Indices> struct column_storage;
+
+        template <std::size_t... I>
+        struct column_storage<std::index_sequence<I...>> {
+            using type=
+                std::tuple<std::vector<typename Fields::template type<I>>...>;
+        };
+
+        /// The type of the storage for the fields
+        using columns_type= typename column_storage<field_indices>::type;
+
+    public:
+        /// The type of field I
+        template <std::size_t I>
+        using field_type= typename Fields::template type<I>;
+
+        /// A contiguous view of one array of the storage. It covers every slot,
+        /// including those of erased elements.
+        template <typename T> class column_view {
+        public:
+            /// Construct a view of count objects starting at first
+            constexpr column_view(T *first_, std::size_t count_) noexcept :
+                first(first_), count(count_) {}
+
+            /// Return the number of slots in the view
+            constexpr std::size_t size() const noexcept {
+                return count;
+            }
+
+            /// Returns true if the view has no slots, false otherwise
+            constexpr bool empty() const noexcept {
+                return count == 0;
+            }
+
+            /// Return a pointer to the first object
+            constexpr T *data() const noexcept {
+                return first;
+            }
+
+            /// Return the object for slot i
+            constexpr T &operator[](std::size_t i) const noexcept {
+                return first[i];
+            }
+
+            /// Return a pointer to the first object
+            constexpr T *begin() const noexcept {
+                return first;
+            }
+
+            /// Return a pointer one past the last object
+            constexpr T *end() const noexcept {
+                return first + count;
+            }
+
+        private:
+            /// The first object
+            T *first;
+            /// The number of objects
+            std::size_t count;
+        };
+
+        /// A reference to the fields of one element
+        template <bool is_const> class row_reference {
+            using map_ptr= std::conditional_t<
+                is_const, columnar_ticket_map const *, columnar_ticket_map *>;
+
+        public:
+            /// Return a reference to field I
+            template <std::size_t I>
+            constexpr std::conditional_t<
+                is_const, field_type<I> const &, field_type<I> &>
+            get() const noexcept {
+                return std::get<I>(map->columns)[slot];
+            }
+
+            /// Construct a Value from copies of the fields
+            operator Value() const {
+                return make_value(field_indices());
+            }
+
+            /// Allow constructing a const row_reference from a non-const one
+            template <
+                bool other_const,
+                typename= std::enable_if_t<is_const && !other_const>>
+            constexpr row_reference(
+                row_reference<other_const> const &other) noexcept :
+                map(other.map),
+                slot(other.slot) {}
+
+        private:
+            friend class columnar_ticket_map;
+            friend class row_reference<!is_const>;
+
+            constexpr row_reference(map_ptr map_, std::size_t slot_) noexcept :
+                map(map_), slot(slot_) {}
+
+            template <std::size_t... I>
+            Value make_value(std::index_sequence<I...>) const {
+                return Fields::make(get<I>()...);
+            }
+
+            /// The map
+            map_ptr map;
+            /// The slot of the element
+            std::size_t slot;
+        };
+
+    private:
+        /// The iterator for our map
+        template <bool is_const> class iterator_impl {
+            using map_ptr= std::conditional_t<
+                is_const, columnar_ticket_map const *, columnar_ticket_map *>;
+
+        public:
+            /// The value_type of our iterator is a ticket/row pair.
+            struct value_type {
+                /// A reference to the ticket value for this element
+                Ticket const &ticket;
+                /// A reference to the fields of this element
+                row_reference<is_const> value;
+            };
+
+        private:
+            /// It's an input iterator, so we need a proxy for ->
+            struct arrow_proxy {
+                /// Our proxy operator->
+                value_type *operator->() noexcept {
+                    return &value;
+                }
+
+                /// The pointed-to value
+                value_type value;
+            };
+
+        public:
+            /// Required iterator typedefs
+            using reference= value_type;
+            /// Required iterator typedefs
+            using iterator_category= std::input_iterator_tag;
+            /// Required iterator typedefs
+            using pointer= value_type *;
+            /// Required iterator typedefs
+            using difference_type= void;
+
+            /// Compare iterators for inequality.
+            friend bool operator!=(
+                iterator_impl const &lhs, iterator_impl const &rhs) noexcept {
+                return lhs.slot != rhs.slot;
+            }
+
+            /// Equality in terms of iterator_impls: if it's not not-equal then
+            /// it must be equal
+            friend bool operator==(
+                iterator_impl const &lhs, iterator_impl const &rhs) noexcept {
+                return !(lhs != rhs);
+            }
+
+            /// Dereference the iterator
+            const value_type operator*() const noexcept {
+                return value_type{
+                    map->ticketData[slot], row_reference<is_const>(map, slot)};
+            }
+
+            /// Dereference for iter->m
+            arrow_proxy operator->() const noexcept {
+                return arrow_proxy{**this};
+            }
+
+            /// Pre-increment
+            iterator_impl &operator++() noexcept {
+                slot= map->next_valid(slot + 1);
+                return *this;
+            }
+
+            /// Post-increment
+            iterator_impl operator++(int) noexcept {
+                iterator_impl temp{*this};
+                ++*this;
+                return temp;
+            }
+
+            /// Allow constructing a const_iterator from a non-const iterator,
+            /// but not vice-versa
+            template <
+                typename Other,
+                typename= std::enable_if_t<
+                    std::is_same<Other, iterator_impl<false>>::value &&
+                    is_const>>
+            constexpr iterator_impl(Other const &other) noexcept :
+                slot(other.slot), map(other.map) {}
+
+            /// A default-constructed iterator is a sentinel value
+            constexpr iterator_impl() noexcept= default;
+
+        private:
+            friend class columnar_ticket_map;
+            friend class iterator_impl<!is_const>;
+
+            /// Construct from a slot index into a map
+            constexpr iterator_impl(std::size_t slot_, map_ptr map_) noexcept :
+                slot(slot_), map(map_) {}
+
+            /// The slot index
+            std::size_t slot= 0;
+            /// The map
+            map_ptr map= nullptr;
+        };
+
+    public:
+        /// Standard iterator typedef
+        using iterator= iterator_impl<false>;
+        /// Standard const_iterator typedef
+        using const_iterator= iterator_impl<true>;
+
+        /// Construct an empty map
+        columnar_ticket_map() noexcept : nextId(), filledItems(0) {}
+
+        /// Move-construct from other. The elements of other are transferred to
+        /// *this; other is left empty
+        columnar_ticket_map(columnar_ticket_map &&other) noexcept :
+            overflow(other.overflow), nextId(std::move(other.nextId)),
+            ticketData(std::move(other.ticketData)),
+            occupied(std::move(other.occupied)),
+            columns(std::move(other.columns)),
+            filledItems(std::exchange(other.filledItems, 0)),
+            slotCapacity(std::exchange(other.slotCapacity, 0)) {
+            other.clear();
+        }
+
+        /// Copy-construct from other. *this will have the same elements and
+        /// next ticket value as other.
+        columnar_ticket_map(columnar_ticket_map const &other) :
+            overflow(other.overflow), nextId(other.nextId),
+            ticketData(other.ticketData), occupied(other.occupied),
+            columns(other.columns), filledItems(other.filledItems),
+            slotCapacity(other.ticketData.size()) {}
+
+        /// Copy-assign from other
+        columnar_ticket_map &operator=(columnar_ticket_map const &other) {
+            columnar_ticket_map temp(other);
+            swap(temp);
+            return *this;
+        }
+
+        /// Move-assign from other
+        columnar_ticket_map &operator=(columnar_ticket_map &&other) noexcept {
+            columnar_ticket_map temp(std::move(other));
+            swap(temp);
+            return *this;
+        }
+
+        /// Returns true if there are no elements currently in the map, false
+        /// otherwise
+        bool empty() const noexcept {
+            return size() == 0;
+        }
+
+        /// Returns the number of elements currently in the map
+        std::size_t size() const noexcept {
+            return filledItems;
+        }
+
+        /// Insert a new value into the map, splitting it into its fields. It
+        /// is assigned a new ticket value. Returns the ticket for the new
+        /// entry.
+        /// Invalidates any existing iterators into the map.
+        /// Throws overflow_error if the Ticket values have overflowed.
+        Ticket insert(Value v) {
+            return insert_fields(std::move(v), field_indices());
+        }
+
+        /// Insert a new value into the map, given the values for each of its
+        /// fields. It is assigned a new ticket value. Returns the ticket for
+        /// the new entry.
+        /// Invalidates any existing iterators into the map.
+        /// Throws overflow_error if the Ticket values have overflowed.
+        template <typename... Args> Ticket emplace(Args &&... args) {
+            static_assert(
+                sizeof...(Args) == Fields::count,
+                "There must be one argument for each field");
+            if(overflow)
+                throw std::overflow_error(
+                    "Ticket values overflowed; cannot insert");
+            if(ticketData.size() == slotCapacity) {
+                grow();
+            }
+            ticketData.push_back(nextId);
+            push_fields(field_indices(), std::forward<Args>(args)...);
+            occupied.push_back(1);
+            ++filledItems;
+            return detail::increment_with_overflow_check(nextId, overflow);
+        }
+
+        /// Insert a new value into the map with a ticket supplied by the
+        /// caller, such as when restoring a map that was previously saved.
+        /// The ticket must be greater than any ticket previously issued by the
+        /// map. Tickets subsequently issued by the map follow on from the
+        /// supplied ticket. Returns an iterator referring to the new element.
+        /// Invalidates any existing iterators into the map.
+        /// Throws invalid_argument if the ticket is not greater than every
+        /// ticket previously issued.
+        iterator insert_with_ticket(Ticket const &ticket, Value v) {
+            if(overflow || ticket < nextId)
+                throw std::invalid_argument(
+                    "Ticket is not greater than all previous tickets");
+            auto const previous= nextId;
+            nextId= ticket;
+            try {
+                insert(std::move(v));
+            } catch(...) {
+                nextId= previous;
+                throw;
+            }
+            return {ticketData.size() - 1, this};
+        }
+
+        /// Find a value in the map by its ticket. Returns an iterator referring
+        /// to the found element, or end() if no element could be found
+        const_iterator find(const Ticket &ticket) const noexcept {
+            return {lookup(ticket), this};
+        }
+
+        /// Find a value in the map by its ticket. Returns an iterator referring
+        /// to the found element, or end() if no element could be found
+        iterator find(const Ticket &ticket) noexcept {
+            return {lookup(ticket), this};
+        }
+
+        /// Find a value in the map by its ticket. Returns a reference to the
+        /// fields of the found element. Throws std:out_of_range if the value
+        /// was not present.
+        row_reference<false> operator[](const Ticket &ticket) {
+            return {this, index(ticket)};
+        }
+
+        /// Find a value in the map by its ticket. Returns a reference to the
+        /// fields of the found element. Throws std:out_of_range if the value
+        /// was not present.
+        row_reference<true> operator[](const Ticket &ticket) const {
+            return {this, index(ticket)};
+        }
+
+        /// Find a value in the map by its ticket. Returns a tuple of references
+        /// to the fields of the found element, suitable for structured
+        /// bindings. Throws std:out_of_range if the value was not present.
+        auto fields(const Ticket &ticket) {
+            return tie_fields(index(ticket), field_indices());
+        }
+
+        /// Find a value in the map by its ticket. Returns a tuple of references
+        /// to the fields of the found element, suitable for structured
+        /// bindings. Throws std:out_of_range if the value was not present.
+        auto fields(const Ticket &ticket) const {
+            return tie_fields(index(ticket), field_indices());
+        }
+
+        /// Return the number of entries for a ticket in the container. The
+        /// return value is 1 if the ticket is in the container, 0 otherwise.
+        std::size_t count(Ticket const &ticket) const noexcept {
+            return lookup(ticket) == ticketData.size() ? 0 : 1;
+        }
+
+        /// Returns an iterator to the first element, or end() if the container
+        /// is empty
+        iterator begin() noexcept {
+            return {next_valid(0), this};
+        }
+
+        /// Returns an iterator one-past-the-end of the container
+        iterator end() noexcept {
+            return {ticketData.size(), this};
+        }
+
+        /// Returns a const_iterator to the first element, or end() if the
+        /// container is empty
+        const_iterator begin() const noexcept {
+            return {next_valid(0), this};
+        }
+
+        /// Returns a const_iterator one-past-the-end of the container
+        const_iterator end() const noexcept {
+            return {ticketData.size(), this};
+        }
+
+        /// Returns a const_iterator to the first element, or cend() if the
+        /// container is empty
+        const_iterator cbegin() const noexcept {
+            return begin();
+        }
+
+        /// Returns a const_iterator one-past-the-end of the container
+        const_iterator cend() const noexcept {
+            return end();
+        }
+
+        /// Remove an element with the specified ticket. Returns an iterator to
+        /// the next element if there is one, or end() otherwise. Returns end()
+        /// if there was no element with the specified ticket.
+        /// Invalidates any existing iterators into the map.
+        /// Compacts the data if there are too many empty slots.
+        iterator erase(const Ticket &ticket) {
+            return {erase_slot(lookup(ticket)), this};
+        }
+
+        /// Remove the element referenced by the provided iterator.
+        /// Returns an iterator to the next element if there is one, or end()
+        /// otherwise.
+        /// Invalidates any existing iterators into the map.
+        /// Compacts the data if there are too many empty slots.
+        iterator erase(const_iterator pos) {
+            return {erase_slot(pos.slot), this};
+        }
+
+        /// Swap the contents with other.
+        void swap(columnar_ticket_map &other) noexcept {
+            using std::swap;
+            swap(overflow, other.overflow);
+            swap(nextId, other.nextId);
+            ticketData.swap(other.ticketData);
+            occupied.swap(other.occupied);
+            columns.swap(other.columns);
+            swap(filledItems, other.filledItems);
+            swap(slotCapacity, other.slotCapacity);
+        }
+
+        /// Remove all elements from *this. Invalidates all iterators into the
+        /// map.
+        void clear() noexcept {
+            ticketData.clear();
+            occupied.clear();
+            std::apply(
+                [](auto &... column) { (column.clear(), ...); }, columns);
+            filledItems= 0;
+        }
+
+        /// Ensure the map has room for at least count items
+        void reserve(std::size_t count) {
+            compact();
+            if(count > slotCapacity) {
+                ticketData.reserve(count);
+                occupied.reserve(count);
+                std::apply(
+                    [&](auto &... column) { (column.reserve(count), ...); },
+                    columns);
+                slotCapacity= count;
+            }
+        }
+
+        /// Return the maximum number of items that can be inserted without
+        /// reallocating
+        std::size_t insert_capacity() const noexcept {
+            return slotCapacity - ticketData.size();
+        }
+
+        /// Return the number of slots the storage can hold without
+        /// reallocating, including slots for erased elements that have not
+        /// yet been compacted away
+        std::size_t capacity() const noexcept {
+            return slotCapacity;
+        }
+
+        /// Return a view of the values of field I for every slot in the
+        /// storage. The slots of erased elements hold default-constructed
+        /// values. The view is invalidated by anything that invalidates
+        /// iterators.
+        template <std::size_t I> column_view<field_type<I>> column() noexcept {
+            auto &column= std::get<I>(columns);
+            return {column.data(), column.size()};
+        }
+
+        /// Return a view of the values of field I for every slot in the
+        /// storage. The slots of erased elements hold default-constructed
+        /// values. The view is invalidated by anything that invalidates
+        /// iterators.
+        template <std::size_t I>
+        column_view<field_type<I> const> column() const noexcept {
+            auto &column= std::get<I>(columns);
+            return {column.data(), column.size()};
+        }
+
+        /// Return a view of the tickets for every slot in the storage. The
+        /// view is invalidated by anything that invalidates iterators.
+        column_view<Ticket const> tickets() const noexcept {
+            return {ticketData.data(), ticketData.size()};
+        }
+
+        /// Return a view of whether or not each slot in the storage holds an
+        /// element: 1 if it does, 0 if not. The view is invalidated by
+        /// anything that invalidates iterators.
+        column_view<unsigned char const> occupancy() const noexcept {
+            return {occupied.data(), occupied.size()};
+        }
+
+    private:
+        /// Find the index of the first slot at or after slot that holds an
+        /// element
+        std::size_t next_valid(std::size_t slot) const noexcept {
+            for(; slot != occupied.size() && !occupied[slot]; ++slot)
+                ;
+            return slot;
+        }
+
+        /// Find the slot for an element based on a ticket value. Returns
+        /// ticketData.size() if there is no such element.
+        std::size_t lookup(Ticket const &ticket) const noexcept {
+            auto pos= std::lower_bound(
+                          ticketData.begin(), ticketData.end(), ticket) -
+                      ticketData.begin();
+            if(static_cast<std::size_t>(pos) == ticketData.size() ||
+               ticketData[pos] != ticket ||
+               !occupied[pos])
+                return ticketData.size();
+            return pos;
+        }
+
+        /// Find the slot for an element based on a ticket value. Throws
+        /// std::out_of_range if there is no such element.
+        std::size_t index(Ticket const &ticket) const {
+            auto slot= lookup(ticket);
+            if(slot == ticketData.size())
+                throw std::out_of_range("No entry for specified ticket");
+            return slot;
+        }
+
+        /// Return a tuple of references to the fields in a slot
+        template <std::size_t... I>
+        std::tuple<field_type<I> &...>
+        tie_fields(std::size_t slot, std::index_sequence<I...>) noexcept {
+            return {std::get<I>(columns)[slot]...};
+        }
+
+        /// Return a tuple of references to the fields in a slot
+        template <std::size_t... I>
+        std::tuple<field_type<I> const &...>
+        tie_fields(std::size_t slot, std::index_sequence<I...>) const noexcept {
+            return {std::get<I>(columns)[slot]...};
+        }
+
+        /// Insert the fields of a value
+        template <std::size_t... I>
+        Ticket insert_fields(Value &&v, std::index_sequence<I...>) {
+            return emplace(Fields::template get<I>(std::move(v))...);
+        }
+
+        /// Append one value to each field array. If any throws, the tickets
+        /// and fields added so far are removed.
+        template <std::size_t... I, typename... Args>
+        void push_fields(std::index_sequence<I...>, Args &&... args) {
+            std::size_t pushed= 0;
+            try {
+                ((std::get<I>(columns).push_back(std::forward<Args>(args)),
+                  ++pushed),
+                 ...);
+            } catch(...) {
+                ((I < pushed ? std::get<I>(columns).pop_back() : void()), ...);
+                ticketData.pop_back();
+                throw;
+            }
+        }
+
+        /// Make room for more slots, compacting first if that frees enough
+        void grow() {
+            if(needs_compaction()) {
+                compact();
+            } else {
+                reserve(std::max<std::size_t>(size() * 2, 1));
+            }
+        }
+
+        /// Erase the element in a slot. Returns the slot of the next element,
+        /// or ticketData.size() if there is none
+        std::size_t erase_slot(std::size_t slot) {
+            if(slot == ticketData.size())
+                return slot;
+            occupied[slot]= 0;
+            std::apply(
+                [&](auto &... column) {
+                    ((column[slot]= typename std::remove_reference_t<
+                          decltype(column)>::value_type()),
+                     ...);
+                },
+                columns);
+            --filledItems;
+            slot= next_valid(slot);
+            if(needs_compaction()) {
+                auto const next_ticket= slot != ticketData.size() ?
+                                            std::optional(ticketData[slot]) :
+                                            std::nullopt;
+                compact();
+                slot= next_ticket ? lookup(*next_ticket) : ticketData.size();
+            }
+            return slot;
+        }
+
+        /// Returns true if the container has too many empty slot, false
+        /// otherwise
+        bool needs_compaction() const noexcept {
+            return filledItems < (ticketData.size() / 2);
+        }
+
+        /// Compact the container to remove all empty slots.
+        void compact() {
+            std::size_t dest= 0;
+            for(std::size_t source= 0; source != ticketData.size(); ++source) {
+                if(!occupied[source])
+                    continue;
+                if(dest != source) {
+                    ticketData[dest]= std::move(ticketData[source]);
+                    occupied[dest]= 1;
+                    std::apply(
+                        [&](auto &... column) {
+                            ((column[dest]= std::move(column[source])), ...);
+                        },
+                        columns);
+                }
+                ++dest;
+            }
+            ticketData.resize(dest);
+            occupied.resize(dest);
+            std::apply(
+                [&](auto &... column) { (column.resize(dest), ...); }, columns);
+        }
+
+        bool overflow= false;
+        Ticket nextId;
+        std::vector<Ticket> ticketData;
+        /// Whether each slot holds an element
+        std::vector<unsigned char> occupied;
+        /// The arrays for each field
+        columns_type columns;
+        std::size_t filledItems;
+        /// The number of slots each array has room for
+        std::size_t slotCapacity= 0;
+    };
+} // namespace jss
+
+namespace std {
+
+    template <typename Ticket, typename Value, typename Fields>
+    void swap(
+        jss::columnar_ticket_map<Ticket, Value, Fields> &lhs,
+        jss::columnar_ticket_map<Ticket, Value, Fields> &rhs) noexcept {
+        lhs.swap(rhs);
+    }
+} // namespace std
@@ -0,0 +1,234 @@
+// This code is released under the Boost Software License
+// https://www.boost.org/LICENSE_1_0.txt
+// (C) Copyright 2021 Anthony Williams
+
+#pragma once
+
+#include "ticket_map.hpp"
+#include <cstdlib>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+namespace jss {
+
+    /// A ticket_map with a single owning thread that inserts, finds and
+    /// reclaims elements, but which any thread may erase from at any time.
+    /// Erasing just counts the erasure and clears the ticket's bit in an
+    /// occupancy bitmap with atomic operations, without taking a lock: the
+    /// element is only destroyed, and the map compacted, when the owning
+    /// thread next calls maintain().
+    ///
+    /// The bitmap is indexed by ticket, and is never moved once allocated, so
+    /// it takes one bit for every ticket ever issued. Ticket must be an
+    /// integral type.
+    template <
+        typename Ticket, typename Value,
+        typename Policy= default_ticket_map_policy>
+    class concurrent_erase_ticket_map {
+        static_assert(
+            std::is_integral_v<Ticket>, "Ticket must be an integral type");
+
+        /// A word of the occupancy bitmap
+        using word_type= std::uint64_t;
+        /// The number of bits in a word
+        static constexpr std::size_t word_bits= 64;
+        /// The number of words in the first segment of the bitmap. Each
+        /// segment is twice the size of the one before, so a fixed number of
+        /// segments covers every possible ticket.
+        static constexpr std::size_t first_segment_words= 64;
+        /// The maximum number of segments
+        static constexpr std::size_t max_segments=
+            std::numeric_limits<std::size_t>::digits;
+
+    public:
+        /// Construct an empty map
+        concurrent_erase_ticket_map()= default;
+
+        /// Construct an empty map with the specified policy
+        explicit concurrent_erase_ticket_map(Policy policy) :
+            map(std::move(policy)) {}
+
+        concurrent_erase_ticket_map(concurrent_erase_ticket_map const &)=
+            delete;
+        concurrent_erase_ticket_map &
+        operator=(concurrent_erase_ticket_map const &)= delete;
+
+        /// Destroy the map. No other thread may be erasing elements.
+        ~concurrent_erase_ticket_map() {
+            for(auto &segment : segments) {
+                delete[] segment.load(std::memory_order_relaxed);
+            }
+        }
+
+        /// Insert a new value into the map. It is assigned a new ticket value.
+        /// Returns the ticket for the new entry.
+        /// Throws overflow_error if the Ticket values have overflowed.
+        /// Must only be called by the owning thread.
+        Ticket insert(Value v) {
+            return emplace(std::move(v));
+        }
+
+        /// Insert a new value into the map, constructed from args. It is
+        /// assigned a new ticket value. Returns the ticket for the new entry.
+        /// Throws overflow_error if the Ticket values have overflowed.
+        /// Must only be called by the owning thread.
+        template <typename... Args> Ticket emplace(Args &&... args) {
+            auto const index= issued.load(std::memory_order_relaxed);
+            auto &word= allocate_word(index);
+            auto ticket= map.emplace(std::forward<Args>(args)...);
+            word.fetch_or(bit_for(index), std::memory_order_relaxed);
+            issued.store(index + 1, std::memory_order_release);
+            ++inserted;
+            return ticket;
+        }
+
+        /// Remove the element with the specified ticket. Returns true if there
+        /// was such an element, false otherwise. May be called from any
+        /// thread. The element is destroyed by the next call to maintain().
+        bool erase(Ticket const &ticket) noexcept {
+            auto const index= static_cast<std::size_t>(ticket);
+            if(!was_issued(ticket, std::memory_order_acquire))
+                return false;
+            // Count the erasure before clearing the bit, so maintain() never
+            // destroys an element that size() still counts
+            erasures.fetch_add(1, std::memory_order_relaxed);
+            auto const bit= bit_for(index);
+            if(!(word_for(index).fetch_and(~bit, std::memory_order_release) &
+                 bit)) {
+                erasures.fetch_sub(1, std::memory_order_relaxed);
+                return false;
+            }
+            return true;
+        }
+
+        /// Find a value in the map by its ticket. Returns a pointer to the
+        /// value, or nullptr if there is no element with that ticket. Must
+        /// only be called by the owning thread, and the value must not be used
+        /// once another thread may have erased it.
+        Value *find(Ticket const &ticket) noexcept {
+            if(!count(ticket))
+                return nullptr;
+            return &map.find(ticket)->value;
+        }
+
+        /// Returns 1 if there is an element with the specified ticket, 0
+        /// otherwise. Must only be called by the owning thread.
+        std::size_t count(Ticket const &ticket) const noexcept {
+            auto const index= static_cast<std::size_t>(ticket);
+            if(!was_issued(ticket, std::memory_order_relaxed))
+                return 0;
+            return (word_for(index).load(std::memory_order_relaxed) &
+                    bit_for(index)) != 0;
+        }
+
+        /// Returns the number of elements in the map that have not been
+        /// erased. Must only be called by the owning thread.
+        std::size_t size() const noexcept {
+            return inserted - erasures.load(std::memory_order_relaxed);
+        }
+
+        /// Returns true if every element has been erased, false otherwise.
+        /// Must only be called by the owning thread.
+        bool empty() const noexcept {
+            return size() == 0;
+        }
+
+        /// Returns the number of erased elements that have not yet been
+        /// destroyed by maintain(). Must only be called by the owning thread.
+        std::size_t pending_erasures() const noexcept {
+            return map.size() - size();
+        }
+
+        /// Destroy the elements that have been erased since the last call,
+        /// compacting the map at most once. Returns the number of elements
+        /// destroyed. Must only be called by the owning thread.
+        std::size_t maintain() {
+            if(!pending_erasures())
+                return 0;
+            std::size_t destroyed= 0;
+            {
+                auto batch= map.batch();
+                auto const tickets= map.tickets();
+                auto const occupancy= map.occupancy();
+                for(std::size_t i= 0; i != tickets.size(); ++i) {
+                    if(occupancy[i] && !count(tickets[i])) {
+                        batch.erase(tickets[i]);
+                        ++destroyed;
+                    }
+                }
+            }
+            // Synchronize with the erasures seen, so size() counts them all
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return destroyed;
+        }
+
+    private:
+        /// Returns true if ticket has been issued, false otherwise
+        bool was_issued(
+            Ticket const &ticket, std::memory_order order) const noexcept {
+            if constexpr(std::is_signed_v<Ticket>) {
+                if(ticket < 0)
+                    return false;
+            }
+            return static_cast<std::size_t>(ticket) < issued.load(order);
+        }
+
+        /// The segment holding the bit for a ticket index, and the index of
+        /// the word in that segment
+        static std::pair<std::size_t, std::size_t>
+        locate(std::size_t index) noexcept {
+            auto const word= index / word_bits;
+            auto const scaled= word / first_segment_words + 1;
+            std::size_t segment= 0;
+            while(scaled >> (segment + 1))
+                ++segment;
+            return {
+                segment,
+                word - first_segment_words * ((std::size_t(1) << segment) - 1)};
+        }
+
+        /// The bit for a ticket index within its word
+        static word_type bit_for(std::size_t index) noexcept {
+            return word_type(1) << (index % word_bits);
+        }
+
+        /// The word holding the bit for a ticket index, which must already
+        /// have been issued
+        std::atomic<word_type> &word_for(std::size_t index) const noexcept {
+            auto const [segment, word]= locate(index);
+            return segments[segment].load(std::memory_order_relaxed)[word];
+        }
+
+        /// The word holding the bit for a ticket index, allocating its segment
+        /// if this is the first ticket in the segment
+        std::atomic<word_type> &allocate_word(std::size_t index) {
+            auto const [segment, word]= locate(index);
+            auto words= segments[segment].load(std::memory_order_relaxed);
+            if(!words) {
+                words= new std::atomic<word_type>
+                    [first_segment_words << segment]();
+                segments[segment].store(words, std::memory_order_relaxed);
+            }
+            return words[word];
+        }
+
+        /// The segments of the occupancy bitmap. Published to erasing threads
+        /// by the release store to issued.
+        mutable std::atomic<std::atomic<word_type> *>
+            segments[max_segments]= {};
+        /// The number of tickets issued so far
+        std::atomic<std::size_t> issued{0};
+        /// The number of elements erased so far, by any thread. Incremented
+        /// before the element's bit is cleared, so briefly includes erasures
+        /// that turn out to have failed.
+        alignas(64) std::atomic<std::size_t> erasures{0};
+        /// The number of elements inserted so far
+        alignas(64) std::size_t inserted= 0;
+        /// The underlying map, which still holds erased elements until they
+        /// are reclaimed
+        ticket_map<Ticket, Value, Policy> map;
+    };
+} // namespace jss
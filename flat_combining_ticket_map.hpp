@@ -0,0 +1,228 @@
+// This code is released under the Boost Software License
+// https://www.boost.org/LICENSE_1_0.txt
+// (C) Copyright 2021 Anthony Williams
+
+#pragma once
+
+#include "ticket_map.hpp"
+#include <cstdlib>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <thread>
+#include <utility>
+
+namespace jss {
+
+    /// A ticket_map that can be used from multiple threads at once, using
+    /// flat combining. Each thread publishes its operation in one of Slots
+    /// publication slots, and whichever thread holds the combiner lock applies
+    /// all the published operations to the underlying map as one batch, so
+    /// the map stays in one core's cache and is compacted at most once per
+    /// batch. Threads that don't hold the lock just wait for their operation
+    /// to be done.
+    template <
+        typename Ticket, typename Value, std::size_t Slots= 64,
+        typename Policy= default_ticket_map_policy>
+    class flat_combining_ticket_map {
+        static_assert(Slots > 0, "There must be at least one slot");
+
+        /// The kinds of operation
+        enum class operation { insert, erase, find };
+
+        /// The states of a publication slot
+        enum class slot_state { empty, claimed, pending, done };
+
+        /// A publication slot. Each is on its own cache line.
+        struct alignas(64) publication {
+            /// The state of the slot
+            std::atomic<slot_state> state{slot_state::empty};
+            /// The operation to apply
+            operation op;
+            /// The ticket for the operation, or the new ticket for an insert
+            Ticket ticket;
+            /// The value to insert, or the value found
+            std::optional<Value> value;
+            /// True if an erase removed an element, false otherwise
+            bool erased;
+            /// The exception thrown by the operation, if any
+            std::exception_ptr error;
+        };
+
+    public:
+        /// Construct an empty map
+        flat_combining_ticket_map()= default;
+
+        /// Construct an empty map with the specified policy
+        explicit flat_combining_ticket_map(Policy policy) :
+            map(std::move(policy)) {}
+
+        flat_combining_ticket_map(flat_combining_ticket_map const &)= delete;
+        flat_combining_ticket_map &
+        operator=(flat_combining_ticket_map const &)= delete;
+
+        /// Insert a new value into the map. It is assigned a new ticket value.
+        /// Returns the ticket for the new entry.
+        /// Throws overflow_error if the Ticket values have overflowed.
+        Ticket insert(Value v) {
+            auto &slot= claim_slot();
+            slot.op= operation::insert;
+            slot.value.emplace(std::move(v));
+            run(slot);
+            return release_slot(slot, [&] { return std::move(slot.ticket); });
+        }
+
+        /// Remove the element with the specified ticket. Returns true if there
+        /// was such an element, false otherwise.
+        bool erase(Ticket const &ticket) {
+            auto &slot= claim_slot();
+            slot.op= operation::erase;
+            slot.ticket= ticket;
+            run(slot);
+            return release_slot(slot, [&] { return slot.erased; });
+        }
+
+        /// Find a value in the map by its ticket. Returns a copy of the value,
+        /// or an empty optional if there is no element with that ticket.
+        std::optional<Value> find(Ticket const &ticket) {
+            auto &slot= claim_slot();
+            slot.op= operation::find;
+            slot.ticket= ticket;
+            run(slot);
+            return release_slot(slot, [&] { return std::move(slot.value); });
+        }
+
+        /// Returns the number of elements currently in the map. Concurrent
+        /// operations may change it at any time.
+        std::size_t size() const noexcept {
+            return count.load(std::memory_order_relaxed);
+        }
+
+        /// Returns true if there are no elements currently in the map, false
+        /// otherwise. Concurrent operations may change it at any time.
+        bool empty() const noexcept {
+            return size() == 0;
+        }
+
+    private:
+        /// Claim a free publication slot, starting the search from one chosen
+        /// by the thread's ID to spread threads across the slots
+        publication &claim_slot() noexcept {
+            auto index=
+                std::hash<std::thread::id>()(std::this_thread::get_id());
+            for(;; ++index) {
+                auto &slot= slots[index % Slots];
+                auto expected= slot_state::empty;
+                if(slot.state.load(std::memory_order_relaxed) == expected &&
+                   slot.state.compare_exchange_strong(
+                       expected, slot_state::claimed,
+                       std::memory_order_acquire)) {
+                    return slot;
+                }
+                if(index % Slots == Slots - 1) {
+                    std::this_thread::yield();
+                }
+            }
+        }
+
+        /// Publish the operation in slot, and wait until it has been done,
+        /// combining the published operations if nobody else is
+        void run(publication &slot) {
+            slot.error= nullptr;
+            slot.state.store(slot_state::pending, std::memory_order_release);
+            while(slot.state.load(std::memory_order_acquire) !=
+                  slot_state::done) {
+                if(!combining.load(std::memory_order_relaxed) &&
+                   !combining.exchange(true, std::memory_order_acquire)) {
+                    combine();
+                    combining.store(false, std::memory_order_release);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        }
+
+        /// Return the result of the operation in the slot, and free the slot.
+        /// Rethrows the exception if the operation threw.
+        template <typename F>
+        auto release_slot(publication &slot, F result) {
+            struct releaser {
+                publication &slot;
+                ~releaser() {
+                    slot.value.reset();
+                    slot.state.store(
+                        slot_state::empty, std::memory_order_release);
+                }
+            } release{slot};
+            if(slot.error) {
+                std::rethrow_exception(slot.error);
+            }
+            return result();
+        }
+
+        /// Apply all the published operations to the map as a single batch
+        void combine() noexcept {
+            publication *applied[Slots];
+            std::size_t applied_count= 0;
+            {
+                auto batch= map.batch();
+                for(auto &slot : slots) {
+                    if(slot.state.load(std::memory_order_acquire) ==
+                       slot_state::pending) {
+                        apply(batch, slot);
+                        applied[applied_count++]= &slot;
+                    }
+                }
+                try {
+                    batch.commit();
+                } catch(...) {
+                    // Only the pending inserts are lost; the erases and finds
+                    // have already taken effect
+                    auto const error= std::current_exception();
+                    for(std::size_t i= 0; i != applied_count; ++i) {
+                        if(applied[i]->op == operation::insert &&
+                           !applied[i]->error)
+                            applied[i]->error= error;
+                    }
+                }
+            }
+            count.store(map.size(), std::memory_order_relaxed);
+            for(std::size_t i= 0; i != applied_count; ++i) {
+                applied[i]->state.store(
+                    slot_state::done, std::memory_order_release);
+            }
+        }
+
+        /// Apply the operation from one slot as part of a batch
+        template <typename Batch>
+        void apply(Batch &batch, publication &slot) noexcept {
+            try {
+                switch(slot.op) {
+                case operation::insert:
+                    slot.ticket= batch.insert(std::move(*slot.value));
+                    slot.value.reset();
+                    break;
+                case operation::erase:
+                    slot.erased= batch.erase(slot.ticket);
+                    break;
+                case operation::find:
+                    if(batch.count(slot.ticket))
+                        slot.value.emplace(batch[slot.ticket]);
+                    break;
+                }
+            } catch(...) {
+                slot.error= std::current_exception();
+            }
+        }
+
+        /// The publication slots
+        publication slots[Slots];
+        /// Set while a thread is combining
+        alignas(64) std::atomic<bool> combining{false};
+        /// The number of elements, as of the last batch
+        std::atomic<std::size_t> count{0};
+        /// The underlying map, only accessed while combining
+        ticket_map<Ticket, Value, Policy> map;
+    };
+} // namespace jss
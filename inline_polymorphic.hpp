@@ -0,0 +1,143 @@
+// This code is released under the Boost Software License
+// https://www.boost.org/LICENSE_1_0.txt
+// (C) Copyright 2021 Anthony Williams
+
+#pragma once
+
+#include "ticket_map.hpp"
+#include <cstdlib>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace jss {
+
+    /// Holds an object of some class derived from Base (or Base itself)
+    /// directly in its own storage, rather than on the heap. The derived class
+    /// must be no bigger than MaxSize, need no stricter alignment than
+    /// MaxAlign, and be nothrow move-constructible. Moving an
+    /// inline_polymorphic moves the contained object, leaving the source
+    /// holding a moved-from object.
+    ///
+    /// Used as the Value type of a ticket_map, this avoids an allocation for
+    /// each element and the pointer chase to reach it that storing a
+    /// std::unique_ptr<Base> requires. See inline_polymorphic_ticket_map.
+    template <
+        typename Base, std::size_t MaxSize,
+        std::size_t MaxAlign= alignof(std::max_align_t)>
+    class inline_polymorphic {
+        /// The operations on the contained object that depend on its type
+        struct operations {
+            /// Move-construct the object in the first storage into the
+            /// second
+            void (*move)(void *, void *) noexcept;
+            /// Destroy the object in the storage
+            void (*destroy)(void *) noexcept;
+        };
+
+        /// The operations for a Derived object
+        template <typename Derived>
+        static constexpr operations operations_for{
+            [](void *source, void *dest) noexcept {
+                new(dest) Derived(
+                    std::move(*std::launder(static_cast<Derived *>(source))));
+            },
+            [](void *storage) noexcept {
+                std::launder(static_cast<Derived *>(storage))->~Derived();
+            }};
+
+    public:
+        /// Construct an object of type Derived from args in the storage
+        template <typename Derived, typename... Args>
+        explicit inline_polymorphic(
+            std::in_place_type_t<Derived>, Args &&... args) :
+            ops(&operations_for<Derived>) {
+            static_assert(
+                std::is_base_of_v<Base, Derived>,
+                "Derived must derive from Base");
+            static_assert(sizeof(Derived) <= MaxSize, "Derived is too big");
+            static_assert(
+                alignof(Derived) <= MaxAlign,
+                "Derived needs stricter alignment than MaxAlign");
+            static_assert(
+                std::is_nothrow_move_constructible_v<Derived>,
+                "Derived must be nothrow move constructible");
+            Base *const base= new(storage) Derived(std::forward<Args>(args)...);
+            baseOffset= reinterpret_cast<unsigned char *>(base) - storage;
+        }
+
+        /// Move the contained object from other into *this
+        inline_polymorphic(inline_polymorphic &&other) noexcept :
+            ops(other.ops), baseOffset(other.baseOffset) {
+            ops->move(other.storage, storage);
+        }
+
+        /// Replace the contained object with the object from other
+        inline_polymorphic &operator=(inline_polymorphic &&other) noexcept {
+            if(this != &other) {
+                ops->destroy(storage);
+                ops= other.ops;
+                baseOffset= other.baseOffset;
+                ops->move(other.storage, storage);
+            }
+            return *this;
+        }
+
+        /// Destroy the contained object
+        ~inline_polymorphic() {
+            ops->destroy(storage);
+        }
+
+        /// Return a reference to the contained object
+        Base &get() noexcept {
+            return *std::launder(
+                reinterpret_cast<Base *>(storage + baseOffset));
+        }
+
+        /// Return a reference to the contained object
+        Base const &get() const noexcept {
+            return *std::launder(
+                reinterpret_cast<Base const *>(storage + baseOffset));
+        }
+
+        /// Access the contained object
+        Base *operator->() noexcept {
+            return &get();
+        }
+
+        /// Access the contained object
+        Base const *operator->() const noexcept {
+            return &get();
+        }
+
+        /// Return a reference to the contained object
+        Base &operator*() noexcept {
+            return get();
+        }
+
+        /// Return a reference to the contained object
+        Base const &operator*() const noexcept {
+            return get();
+        }
+
+    private:
+        /// The type-specific operations for the contained object
+        operations const *ops;
+        /// The offset of the Base subobject within the storage, recorded on
+        /// construction so get() needs no indirect call
+        std::ptrdiff_t baseOffset;
+        /// The storage for the contained object
+        alignas(MaxAlign) unsigned char storage[MaxSize];
+    };
+
+    /// A ticket_map holding objects of classes derived from Base in place in
+    /// its storage. Insert values with emplace(std::in_place_type<Derived>,
+    /// args...).
+    template <
+        typename Ticket, typename Base, std::size_t MaxSize,
+        std::size_t MaxAlign= alignof(std::max_align_t),
+        typename Policy= default_ticket_map_policy>
+    using inline_polymorphic_ticket_map= ticket_map<
+        Ticket, inline_polymorphic<Base, MaxSize, MaxAlign>, Policy>;
+} // namespace jss
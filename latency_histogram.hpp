@@ -0,0 +1,126 @@
+// This code is released under the Boost Software License
+// https://www.boost.org/LICENSE_1_0.txt
+// (C) Copyright 2021 Anthony Williams
+
+#pragma once
+
+#include <cstdlib>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+namespace jss {
+
+    /// A histogram of latencies, or any other non-negative integer values,
+    /// with a fixed relative precision. Values below 32 are counted exactly;
+    /// larger values are counted in 32 buckets for each power of two, so the
+    /// recorded value is within about 3% of the true value, however big it
+    /// is. Recording a value just increments a counter.
+    class latency_histogram {
+        /// The number of buckets per power of two, as a power of two
+        static constexpr unsigned sub_bucket_bits= 5;
+        /// The number of buckets per power of two
+        static constexpr std::uint64_t sub_buckets= 1u << sub_bucket_bits;
+        /// The total number of buckets
+        static constexpr std::size_t bucket_count=
+            (64 - sub_bucket_bits + 1) * sub_buckets;
+
+    public:
+        /// Record a value
+        void record(std::uint64_t value) noexcept {
+            ++buckets[bucket_for(value)];
+            ++total;
+            sum+= value;
+            largest= std::max(largest, value);
+        }
+
+        /// Add the counts from other to this histogram
+        void merge(latency_histogram const &other) noexcept {
+            for(std::size_t i= 0; i != bucket_count; ++i) {
+                buckets[i]+= other.buckets[i];
+            }
+            total+= other.total;
+            sum+= other.sum;
+            largest= std::max(largest, other.largest);
+        }
+
+        /// Returns the number of values recorded
+        std::uint64_t count() const noexcept {
+            return total;
+        }
+
+        /// Returns the largest value recorded, or 0 if there are none
+        std::uint64_t max() const noexcept {
+            return largest;
+        }
+
+        /// Returns the mean of the values recorded, or 0 if there are none
+        double mean() const noexcept {
+            return total ? static_cast<double>(sum) / total : 0.0;
+        }
+
+        /// Returns the value at the specified percentile, from 0 to 100: the
+        /// largest value that could be in the bucket holding that percentile.
+        /// Returns 0 if there are no values.
+        std::uint64_t percentile(double p) const noexcept {
+            if(!total)
+                return 0;
+            auto const rank= static_cast<std::uint64_t>(
+                std::clamp(p, 0.0, 100.0) / 100.0 * (total - 1));
+            std::uint64_t seen= 0;
+            for(std::size_t i= 0; i != bucket_count; ++i) {
+                seen+= buckets[i];
+                if(seen > rank)
+                    return std::min(bucket_limit(i), largest);
+            }
+            return largest;
+        }
+
+        /// Remove all the recorded values
+        void clear() noexcept {
+            buckets.fill(0);
+            total= 0;
+            sum= 0;
+            largest= 0;
+        }
+
+    private:
+        /// Return the index of the most significant set bit in value, which
+        /// must be non-zero
+        static unsigned top_bit(std::uint64_t value) noexcept {
+            unsigned bit= 0;
+            while(value >>= 1)
+                ++bit;
+            return bit;
+        }
+
+        /// Return the bucket that holds value
+        static std::size_t bucket_for(std::uint64_t value) noexcept {
+            if(value < sub_buckets)
+                return static_cast<std::size_t>(value);
+            auto const shift= top_bit(value) - sub_bucket_bits;
+            return static_cast<std::size_t>(
+                (shift + 1) * sub_buckets +
+                ((value >> shift) & (sub_buckets - 1)));
+        }
+
+        /// Return the largest value that goes in the specified bucket
+        static std::uint64_t bucket_limit(std::size_t bucket) noexcept {
+            if(bucket < sub_buckets)
+                return bucket;
+            auto const shift= bucket / sub_buckets - 1;
+            auto const first=
+                (sub_buckets + bucket % sub_buckets) << shift;
+            return first + ((std::uint64_t(1) << shift) - 1);
+        }
+
+        /// The count of values in each bucket
+        std::array<std::uint64_t, bucket_count> buckets{};
+        /// The total number of values
+        std::uint64_t total= 0;
+        /// The sum of the values
+        std::uint64_t sum= 0;
+        /// The largest value
+        std::uint64_t largest= 0;
+    };
+} // namespace jss
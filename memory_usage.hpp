@@ -0,0 +1,75 @@
+// This code is released under the Boost Software License
+// https://www.boost.org/LICENSE_1_0.txt
+// (C) Copyright 2021 Anthony Williams
+
+#pragma once
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+
+#if defined(__GLIBC__) && \
+    (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+#define JSS_HAS_MALLINFO2 1
+#include <malloc.h>
+#else
+#define JSS_HAS_MALLINFO2 0
+#endif
+
+#if defined(__linux__)
+#define JSS_HAS_PROC_STATM 1
+#include <unistd.h>
+#else
+#define JSS_HAS_PROC_STATM 0
+#endif
+
+namespace jss {
+
+    /// Measurements of the memory used by the whole process, for working
+    /// out how much a data structure uses by measuring before and after
+    /// building it. Measurements that the platform doesn't support have no
+    /// value.
+    namespace process_memory {
+
+        /// Returns the number of bytes allocated from the heap and not yet
+        /// freed, as reported by the allocator. Uses mallinfo2 with glibc.
+        inline std::optional<std::size_t> heap_bytes() noexcept {
+#if JSS_HAS_MALLINFO2
+            auto const info= mallinfo2();
+            return info.uordblks + info.hblkhd;
+#else
+            return std::nullopt;
+#endif
+        }
+
+        /// Returns the number of bytes of the process's memory that are
+        /// resident in RAM. Uses /proc/self/statm on Linux.
+        inline std::optional<std::size_t> resident_bytes() noexcept {
+#if JSS_HAS_PROC_STATM
+            auto const file= std::fopen("/proc/self/statm", "r");
+            if(!file)
+                return std::nullopt;
+            unsigned long size= 0;
+            unsigned long resident= 0;
+            auto const fields= std::fscanf(file, "%lu %lu", &size, &resident);
+            std::fclose(file);
+            if(fields != 2)
+                return std::nullopt;
+            return static_cast<std::size_t>(resident) *
+                   static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#else
+            return std::nullopt;
+#endif
+        }
+
+        /// Ask the allocator to return freed memory to the operating system,
+        /// so the resident size reflects the memory actually in use. Does
+        /// nothing where that isn't supported.
+        inline void release_free_memory() noexcept {
+#if JSS_HAS_MALLINFO2
+            malloc_trim(0);
+#endif
+        }
+    } // namespace process_memory
+} // namespace jss
@@ -0,0 +1,188 @@
+// This code is released under the Boost Software License
+// https://www.boost.org/LICENSE_1_0.txt
+// (C) Copyright 2021 Anthony Williams
+
+#pragma once
+
+#include <cstdlib>
+#include <array>
+#include <cstdint>
+#include <optional>
+
+#if defined(__linux__) && __has_include(<linux/perf_event.h>)
+#define JSS_HAS_PERF_EVENTS 1
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#define JSS_HAS_PERF_EVENTS 0
+#endif
+
+namespace jss {
+
+    /// A set of hardware performance counters for the calling thread, read
+    /// with perf_event_open on Linux. Counters that cannot be opened, because
+    /// the platform, the hardware or the kernel's perf_event_paranoid setting
+    /// doesn't allow it, are just reported as unavailable.
+    class perf_counters {
+    public:
+        /// The counters collected
+        enum counter {
+            cycles,
+            instructions,
+            l1d_misses,
+            llc_misses,
+            dtlb_misses,
+            branch_misses,
+            counter_count
+        };
+
+        /// The counts from one measurement. A counter that is unavailable has
+        /// no value.
+        using sample= std::array<std::optional<double>, counter_count>;
+
+        /// Open all the counters that are available
+        perf_counters() noexcept {
+            for(std::size_t i= 0; i != counter_count; ++i) {
+                fds[i]= open_counter(static_cast<counter>(i));
+            }
+        }
+
+        perf_counters(perf_counters const &)= delete;
+        perf_counters &operator=(perf_counters const &)= delete;
+
+        /// Close the counters
+        ~perf_counters() {
+#if JSS_HAS_PERF_EVENTS
+            for(auto fd : fds) {
+                if(fd >= 0)
+                    close(fd);
+            }
+#endif
+        }
+
+        /// Returns the name of a counter
+        static char const *name(counter c) noexcept {
+            static char const *const names[counter_count]= {
+                "cycles",      "instructions", "L1D-miss",
+                "LLC-miss",    "dTLB-miss",    "branch-miss"};
+            return names[c];
+        }
+
+        /// Returns true if the counter could be opened, false otherwise
+        bool available(counter c) const noexcept {
+            return fds[c] >= 0;
+        }
+
+        /// Returns true if any counter could be opened, false otherwise
+        bool any_available() const noexcept {
+            for(auto fd : fds) {
+                if(fd >= 0)
+                    return true;
+            }
+            return false;
+        }
+
+        /// Reset the counters to zero and start counting
+        void start() noexcept {
+#if JSS_HAS_PERF_EVENTS
+            for(auto fd : fds) {
+                if(fd >= 0) {
+                    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+                }
+            }
+#endif
+        }
+
+        /// Stop counting
+        void stop() noexcept {
+#if JSS_HAS_PERF_EVENTS
+            for(auto fd : fds) {
+                if(fd >= 0)
+                    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            }
+#endif
+        }
+
+        /// Read the counts since the last call to start(). If the kernel had
+        /// to share the hardware between more counters than it has, the
+        /// counts are scaled up to estimate the full count.
+        sample read() const noexcept {
+            sample result;
+#if JSS_HAS_PERF_EVENTS
+            for(std::size_t i= 0; i != counter_count; ++i) {
+                std::uint64_t values[3];
+                if(fds[i] < 0 ||
+                   ::read(fds[i], values, sizeof(values)) != sizeof(values) ||
+                   !values[2])
+                    continue;
+                result[i]= static_cast<double>(values[0]) *
+                           static_cast<double>(values[1]) /
+                           static_cast<double>(values[2]);
+            }
+#endif
+            return result;
+        }
+
+    private:
+        /// Open a counter for the calling thread. Returns the file
+        /// descriptor, or -1 if the counter is not available.
+        static int open_counter(counter c) noexcept {
+#if JSS_HAS_PERF_EVENTS
+            perf_event_attr attr{};
+            attr.size= sizeof(attr);
+            attr.disabled= 1;
+            attr.exclude_kernel= 1;
+            attr.exclude_hv= 1;
+            attr.read_format= PERF_FORMAT_TOTAL_TIME_ENABLED |
+                              PERF_FORMAT_TOTAL_TIME_RUNNING;
+            switch(c) {
+            case cycles:
+                attr.type= PERF_TYPE_HARDWARE;
+                attr.config= PERF_COUNT_HW_CPU_CYCLES;
+                break;
+            case instructions:
+                attr.type= PERF_TYPE_HARDWARE;
+                attr.config= PERF_COUNT_HW_INSTRUCTIONS;
+                break;
+            case l1d_misses:
+                attr.type= PERF_TYPE_HW_CACHE;
+                attr.config= cache_event(PERF_COUNT_HW_CACHE_L1D);
+                break;
+            case llc_misses:
+                attr.type= PERF_TYPE_HW_CACHE;
+                attr.config= cache_event(PERF_COUNT_HW_CACHE_LL);
+                break;
+            case dtlb_misses:
+                attr.type= PERF_TYPE_HW_CACHE;
+                attr.config= cache_event(PERF_COUNT_HW_CACHE_DTLB);
+                break;
+            case branch_misses:
+                attr.type= PERF_TYPE_HARDWARE;
+                attr.config= PERF_COUNT_HW_BRANCH_MISSES;
+                break;
+            default:
+                return -1;
+            }
+            auto const fd= syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+            return fd >= 0 ? static_cast<int>(fd) : -1;
+#else
+            (void)c;
+            return -1;
+#endif
+        }
+
+#if JSS_HAS_PERF_EVENTS
+        /// The configuration for read misses in the specified cache
+        static std::uint64_t cache_event(std::uint64_t cache) noexcept {
+            return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                   (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        }
+#endif
+
+        /// The file descriptors for the counters, or -1 if unavailable
+        std::array<int, counter_count> fds;
+    };
+} // namespace jss
@@ -0,0 +1,70 @@
+#include "ticket_map_trace.hpp"
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace {
+    /// The values stored in the maps the trace is replayed against
+    using payload= std::array<std::uint64_t, 4>;
+
+    /// Replay the trace against a map of type Map and print the results
+    template <typename Map>
+    void replay(char const *name, std::string const &trace) {
+        std::istringstream in(trace);
+        Map map;
+        auto const statistics= jss::replay_trace(in, map);
+        std::printf(
+            "%-20s %12llu %10.3f", name,
+            static_cast<unsigned long long>(statistics.operations()),
+            statistics.operations() * 1e3 / statistics.elapsed);
+        using op_type= jss::ticket_map_operation;
+        for(auto op : {op_type::insert, op_type::erase, op_type::find}) {
+            auto const &latency= statistics[op];
+            std::printf(
+                " %8llu %8llu %8llu",
+                static_cast<unsigned long long>(latency.percentile(50)),
+                static_cast<unsigned long long>(latency.percentile(99)),
+                static_cast<unsigned long long>(latency.max()));
+        }
+        std::printf("\n");
+    }
+} // namespace
+
+int main(int argc, char **argv) {
+    std::string trace;
+    if(argc > 1) {
+        std::ifstream file(argv[1], std::ios::binary);
+        if(!file) {
+            std::fprintf(stderr, "Cannot open %s\n", argv[1]);
+            return 1;
+        }
+        std::ostringstream contents;
+        contents << file.rdbuf();
+        trace= contents.str();
+    } else {
+        std::printf("No trace file given; replaying a synthetic trace\n");
+        std::ostringstream synthetic;
+        jss::record_workload(synthetic, jss::workload_spec());
+        trace= synthetic.str();
+    }
+
+    std::printf(
+        "%-20s %12s %10s %27s %27s %27s\n", "configuration", "operations",
+        "Mops/s", "insert ns p50/p99/max", "erase ns p50/p99/max",
+        "find ns p50/p99/max");
+    try {
+        replay<jss::ticket_map<std::uint64_t, payload>>("default", trace);
+        replay<jss::ticket_map<
+            std::uint64_t, payload, jss::release_memory_policy<>>>(
+            "release_memory", trace);
+        replay<jss::ticket_map<
+            std::uint64_t, payload, jss::deferred_compaction_policy<>>>(
+            "deferred_compaction", trace);
+    } catch(std::exception &e) {
+        std::fprintf(stderr, "Replay failed: %s\n", e.what());
+        return 1;
+    }
+}
@@ -0,0 +1,207 @@
+#include "background_compacting_ticket_map.hpp"
+#include <assert.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+void test_basic_operations() {
+    jss::background_compacting_ticket_map<int, std::string> map;
+
+    assert(map.empty());
+    auto ticket= map.insert("hello");
+    auto ticket2= map.emplace(3, 'x');
+    assert(ticket == 0);
+    assert(ticket2 == 1);
+    assert(map.size() == 2);
+    assert(*map.find(ticket) == "hello");
+    assert(*map.find(ticket2) == "xxx");
+    assert(!map.find(42));
+
+    assert(map.erase(ticket));
+    assert(!map.erase(ticket));
+    assert(!map.count(ticket));
+    assert(map.size() == 1);
+}
+
+void test_erasing_starts_background_compaction() {
+    jss::background_compacting_ticket_map<unsigned, unsigned> map;
+
+    unsigned const count= 1000;
+    for(unsigned i= 0; i < count; ++i) {
+        map.insert(i);
+    }
+    assert(!map.compacting());
+    unsigned i= 0;
+    for(; !map.compacting(); ++i) {
+        assert(i < count);
+        assert(map.erase(i));
+    }
+    assert(i > count / 2 - 2);
+    assert(i <= count / 2 + 1);
+    map.wait();
+    assert(!map.compacting());
+    assert(map.size() == count - i);
+    for(unsigned j= 0; j < count; ++j) {
+        assert(map.count(j) == (j >= i));
+    }
+}
+
+void test_operations_during_compaction_are_applied() {
+    jss::background_compacting_ticket_map<unsigned, std::string> map;
+
+    unsigned const count= 100000;
+    for(unsigned i= 0; i < count; ++i) {
+        map.insert(std::to_string(i));
+    }
+    map.compact();
+
+    std::vector<unsigned> added;
+    for(unsigned i= 0; i < 100; ++i) {
+        assert(map.erase(i * 7));
+        assert(!map.find(i * 7));
+        assert(!map.erase(i * 7));
+        added.push_back(map.insert("new" + std::to_string(i)));
+        if(i % 2)
+            assert(map.erase(added.back()));
+    }
+    assert(map.size() == count - 50);
+    map.wait();
+    assert(!map.compacting());
+    assert(map.size() == count - 50);
+
+    for(unsigned i= 0; i < 100; ++i) {
+        assert(!map.count(i * 7));
+        if(i % 2)
+            assert(!map.count(added[i]));
+        else
+            assert(*map.find(added[i]) == "new" + std::to_string(i));
+    }
+    assert(*map.find(1) == "1");
+    assert(*map.find(count - 1) == std::to_string(count - 1));
+    assert(map.insert("last") == count + 100);
+}
+
+void test_respects_policy_threshold() {
+    struct never_compact_policy : jss::default_ticket_map_policy {
+        bool needs_compaction(std::size_t, std::size_t) const noexcept {
+            return false;
+        }
+    };
+    jss::background_compacting_ticket_map<
+        unsigned, unsigned, never_compact_policy>
+        map;
+
+    for(unsigned i= 0; i < 100; ++i) {
+        map.insert(i);
+    }
+    for(unsigned i= 0; i < 99; ++i) {
+        map.erase(i);
+        assert(!map.compacting());
+    }
+    assert(map.size() == 1);
+}
+
+void test_foreground_erase_never_shrinks_storage() {
+    jss::background_compacting_ticket_map<
+        unsigned, unsigned,
+        jss::compaction_threshold_policy<1, 10, jss::release_memory_policy<>>>
+        map;
+
+    for(unsigned i= 0; i < 1000; ++i) {
+        map.insert(i);
+    }
+    auto const capacity= map.capacity();
+    for(unsigned i= 0; i < 850; ++i) {
+        assert(map.erase(i));
+        assert(map.capacity() == capacity);
+    }
+    assert(!map.compacting());
+    assert(map.size() == 150);
+    assert(*map.find(999) == 999);
+}
+
+void test_erasures_during_compaction_in_any_order() {
+    jss::background_compacting_ticket_map<unsigned, unsigned> map;
+
+    unsigned const count= 10000;
+    for(unsigned i= 0; i < count; ++i) {
+        map.insert(i);
+    }
+    map.compact();
+    for(unsigned i= count; i-- > 0;) {
+        if(i % 3 == 0) {
+            assert(map.erase(i));
+            assert(!map.erase(i));
+            assert(!map.find(i));
+        }
+    }
+    assert(map.size() == count - (count + 2) / 3);
+    map.wait();
+    assert(map.size() == count - (count + 2) / 3);
+    for(unsigned i= 0; i < count; ++i) {
+        assert(map.count(i) == (i % 3 != 0));
+    }
+}
+
+/// Counts the inserts reported to a hook_counting_policy, and notes whether
+/// any hook was called on another thread
+struct hook_log {
+    std::thread::id owner= std::this_thread::get_id();
+    std::atomic<unsigned> inserts{0};
+    std::atomic<bool> calledElsewhere{false};
+};
+
+struct hook_counting_policy : jss::default_ticket_map_policy {
+    hook_log *log= nullptr;
+
+    void check_thread() const noexcept {
+        if(std::this_thread::get_id() != log->owner)
+            log->calledElsewhere= true;
+    }
+
+    template <typename Ticket>
+    void on_operation(jss::ticket_map_operation op, Ticket const &) const
+        noexcept {
+        if(!log)
+            return;
+        check_thread();
+        if(op == jss::ticket_map_operation::insert)
+            ++log->inserts;
+    }
+
+    template <typename Map>
+    void on_storage_changed(Map const &) const noexcept {
+        if(log)
+            check_thread();
+    }
+};
+
+void test_background_copy_calls_no_policy_hooks() {
+    hook_log log;
+    hook_counting_policy policy;
+    policy.log= &log;
+    jss::background_compacting_ticket_map<
+        unsigned, unsigned, hook_counting_policy>
+        map(policy);
+
+    for(unsigned i= 0; i < 10000; ++i) {
+        map.insert(i);
+    }
+    map.compact();
+    map.wait();
+    assert(log.inserts == 10000);
+    assert(!log.calledElsewhere);
+    assert(map.size() == 10000);
+    assert(*map.find(1234) == 1234);
+}
+
+int main() {
+    test_basic_operations();
+    test_erasing_starts_background_compaction();
+    test_operations_during_compaction_are_applied();
+    test_respects_policy_threshold();
+    test_foreground_erase_never_shrinks_storage();
+    test_background_copy_calls_no_policy_hooks();
+    test_erasures_during_compaction_in_any_order();
+}
@@ -0,0 +1,195 @@
+#include "columnar_ticket_map.hpp"
+#include <assert.h>
+#include <type_traits>
+#include <string>
+#include <tuple>
+
+struct Session {
+    int id;
+    double score;
+    std::string name;
+};
+
+using session_fields=
+    jss::member_fields<&Session::id, &Session::score, &Session::name>;
+
+void test_initially_empty() {
+    jss::columnar_ticket_map<int, std::tuple<int, double>> map;
+
+    assert(map.empty());
+    assert(map.size() == 0);
+    assert(map.begin() == map.end());
+}
+
+void test_insert_tuple_splits_into_columns() {
+    jss::columnar_ticket_map<int, std::tuple<int, std::string>> map;
+
+    auto ticket= map.insert({42, "hello"});
+    auto ticket2= map.emplace(99, "world");
+    assert(ticket == 0);
+    assert(ticket2 == 1);
+    assert(map.size() == 2);
+
+    assert(map[ticket].get<0>() == 42);
+    assert(map[ticket].get<1>() == "hello");
+    std::tuple<int, std::string> row= map[ticket2];
+    assert(row == std::make_tuple(99, std::string("world")));
+
+    auto ints= map.column<0>();
+    assert(ints.size() == 2);
+    assert(ints[0] == 42);
+    assert(ints[1] == 99);
+    static_assert(std::is_same_v<decltype(ints.data()), int *>);
+    assert(map.column<1>()[1] == "world");
+}
+
+void test_member_fields_of_struct() {
+    jss::columnar_ticket_map<unsigned, Session, session_fields> map;
+
+    auto ticket= map.insert(Session{1, 2.5, "first"});
+    map.insert(Session{2, 3.5, "second"});
+
+    map[ticket].get<1>()= 4.5;
+    Session s= map[ticket];
+    assert(s.id == 1);
+    assert(s.score == 4.5);
+    assert(s.name == "first");
+
+    double total= 0;
+    for(auto score : map.column<1>()) {
+        total+= score;
+    }
+    assert(total == 8);
+
+    auto const &cmap= map;
+    static_assert(
+        std::is_same_v<decltype(cmap.column<2>()[0]), std::string const &>);
+    static_assert(
+        std::is_same_v<decltype(cmap[ticket].get<0>()), int const &>);
+}
+
+void test_iteration_and_erase() {
+    jss::columnar_ticket_map<unsigned short, std::tuple<int, std::string>> map;
+
+    int const count= 1000;
+    for(int i= 0; i < count; ++i) {
+        map.emplace(i, std::to_string(i));
+    }
+
+    auto iter= map.erase(5);
+    assert(iter->ticket == 6);
+    assert(iter->value.get<0>() == 6);
+    assert(!map.count(5));
+    assert(map.find(5) == map.end());
+    assert(map.occupancy()[5] == 0);
+    assert(map.column<1>()[5].empty());
+
+    for(int i= 0; i < count; i+= 2) {
+        map.erase(i);
+    }
+    assert(map.size() == count / 2 - 1);
+    assert(map.tickets().size() < count);
+
+    int expected= 1;
+    for(auto e : map) {
+        if(expected == 5)
+            expected+= 2;
+        assert(e.ticket == expected);
+        assert(e.value.get<0>() == expected);
+        assert(e.value.get<1>() == std::to_string(expected));
+        expected+= 2;
+    }
+
+    iter= map.begin();
+    while(iter != map.end()) {
+        iter= map.erase(iter);
+    }
+    assert(map.empty());
+    assert(map.emplace(1, "x") == count);
+}
+
+void test_lookup_missing_throws() {
+    jss::columnar_ticket_map<int, std::tuple<int>> map;
+
+    map.emplace(1);
+    try {
+        map[1];
+        assert(!"Should throw");
+    } catch(std::out_of_range &) {
+        assert(true);
+    } catch(...) {
+        assert(!"Should throw out-of-range");
+    }
+}
+
+void test_copy_move_and_swap() {
+    jss::columnar_ticket_map<int, std::tuple<int, std::string>> map;
+    for(int i= 0; i < 10; ++i) {
+        map.emplace(i, std::to_string(i));
+    }
+
+    auto copy= map;
+    assert(copy.size() == 10);
+    copy.erase(3);
+    assert(map.count(3));
+    assert(copy.emplace(10, "10") == 10);
+
+    auto moved= std::move(map);
+    assert(moved.size() == 10);
+    assert(map.empty());
+    assert(moved[9].get<1>() == "9");
+
+    std::swap(moved, copy);
+    assert(!moved.count(3));
+    assert(copy.count(3));
+}
+
+void test_cannot_overflow() {
+    jss::columnar_ticket_map<unsigned char, std::tuple<int>> map;
+
+    for(unsigned i= 0; i < 256; ++i) {
+        map.emplace(i);
+    }
+
+    try {
+        map.emplace(-1);
+        assert(!"Should not be able to insert if ticket overflows");
+    } catch(std::overflow_error &) {
+        assert(true);
+    } catch(...) {
+        assert(!"Wrong type of exception thrown");
+    }
+    assert(map.size() == 256);
+}
+
+void test_insert_with_ticket() {
+    jss::columnar_ticket_map<unsigned, std::tuple<int>> map;
+    map.insert(std::make_tuple(1));
+
+    auto it= map.insert_with_ticket(10, std::make_tuple(2));
+    assert(it->ticket == 10);
+    assert(it->value.get<0>() == 2);
+    assert(map.insert(std::make_tuple(3)) == 11);
+    assert(map.size() == 3);
+    assert(map.capacity() >= 3);
+
+    try {
+        map.insert_with_ticket(5, std::make_tuple(4));
+        assert(!"Should not be able to reuse an earlier ticket");
+    } catch(std::invalid_argument &) {
+        assert(true);
+    }
+    assert(map.size() == 3);
+    assert(map.insert(std::make_tuple(5)) == 12);
+}
+
+int main() {
+    test_initially_empty();
+    test_insert_tuple_splits_into_columns();
+    test_member_fields_of_struct();
+    test_iteration_and_erase();
+    test_lookup_missing_throws();
+    test_copy_move_and_swap();
+    test_cannot_overflow();
+    test_insert_with_ticket();
+}
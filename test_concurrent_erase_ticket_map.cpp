@@ -0,0 +1,134 @@
+#include "concurrent_erase_ticket_map.hpp"
+#include <assert.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+void test_erase_is_deferred_until_maintain() {
+    jss::concurrent_erase_ticket_map<int, std::string> map;
+
+    assert(map.empty());
+    auto ticket= map.insert("hello");
+    auto ticket2= map.emplace(3, 'x');
+    assert(map.size() == 2);
+    assert(*map.find(ticket) == "hello");
+    assert(*map.find(ticket2) == "xxx");
+
+    assert(map.erase(ticket));
+    assert(!map.erase(ticket));
+    assert(!map.erase(99));
+    assert(!map.erase(-1));
+    assert(map.size() == 1);
+    assert(!map.count(ticket));
+    assert(!map.find(ticket));
+    assert(map.pending_erasures() == 1);
+
+    assert(map.maintain() == 1);
+    assert(map.pending_erasures() == 0);
+    assert(map.maintain() == 0);
+    assert(map.size() == 1);
+    assert(*map.find(ticket2) == "xxx");
+}
+
+void test_bitmap_spans_segments() {
+    jss::concurrent_erase_ticket_map<unsigned, unsigned> map;
+
+    unsigned const count= 100000;
+    for(unsigned i= 0; i < count; ++i) {
+        assert(map.insert(i) == i);
+    }
+    for(unsigned i= 0; i < count; i+= 3) {
+        assert(map.erase(i));
+    }
+    assert(map.maintain() == (count + 2) / 3);
+    for(unsigned i= 0; i < count; ++i) {
+        assert(map.count(i) == (i % 3 != 0));
+        if(i % 3)
+            assert(*map.find(i) == i);
+    }
+}
+
+void test_erase_from_many_threads() {
+    jss::concurrent_erase_ticket_map<unsigned, std::string> map;
+
+    unsigned const thread_count= 4;
+    unsigned const count= 20000;
+    std::atomic<unsigned> published{0};
+    std::atomic<unsigned> erased{0};
+    std::vector<std::thread> threads;
+
+    for(unsigned t= 0; t < thread_count; ++t) {
+        threads.emplace_back([&, t] {
+            for(unsigned i= t; i < count; i+= thread_count) {
+                while(published.load(std::memory_order_acquire) <= i)
+                    std::this_thread::yield();
+                if(i % 2 && map.erase(i))
+                    ++erased;
+            }
+        });
+    }
+    for(unsigned i= 0; i < count; ++i) {
+        map.insert(std::to_string(i));
+        published.store(i + 1, std::memory_order_release);
+        if(i % 1000 == 0)
+            map.maintain();
+    }
+    for(auto &thread : threads) {
+        thread.join();
+    }
+
+    assert(erased == count / 2);
+    assert(map.size() == count / 2);
+    map.maintain();
+    assert(map.pending_erasures() == 0);
+    for(unsigned i= 0; i < count; ++i) {
+        assert(map.count(i) == (i % 2 == 0));
+    }
+    assert(*map.find(42) == "42");
+}
+
+void test_maintain_racing_with_erasures() {
+    jss::concurrent_erase_ticket_map<unsigned, unsigned> map;
+
+    unsigned const thread_count= 4;
+    unsigned const rounds= 500;
+    unsigned const per_round= 64;
+    std::atomic<unsigned> published{0};
+    std::vector<std::thread> threads;
+    for(unsigned t= 0; t < thread_count; ++t) {
+        threads.emplace_back([&, t] {
+            for(unsigned i= t; i < rounds * per_round; i+= thread_count) {
+                while(published.load(std::memory_order_acquire) <= i)
+                    std::this_thread::yield();
+                assert(map.erase(i));
+                assert(!map.erase(i));
+            }
+        });
+    }
+    for(unsigned round= 0; round < rounds; ++round) {
+        for(unsigned i= 0; i < per_round; ++i) {
+            map.insert(i);
+        }
+        published.store((round + 1) * per_round, std::memory_order_release);
+        while(!map.empty()) {
+            map.maintain();
+            assert(map.pending_erasures() <= per_round);
+            assert(map.size() <= per_round);
+            std::this_thread::yield();
+        }
+    }
+    for(auto &thread : threads) {
+        thread.join();
+    }
+
+    map.maintain();
+    assert(map.pending_erasures() == 0);
+    assert(map.empty());
+}
+
+int main() {
+    test_erase_is_deferred_until_maintain();
+    test_bitmap_spans_segments();
+    test_erase_from_many_threads();
+    test_maintain_racing_with_erasures();
+}
@@ -0,0 +1,140 @@
+#include "flat_combining_ticket_map.hpp"
+#include <assert.h>
+#include <atomic>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+void test_single_threaded_operations() {
+    jss::flat_combining_ticket_map<int, std::string> map;
+
+    assert(map.empty());
+    auto ticket= map.insert("hello");
+    auto ticket2= map.insert("world");
+    assert(ticket == 0);
+    assert(ticket2 == 1);
+    assert(map.size() == 2);
+
+    assert(map.find(ticket) == "hello");
+    assert(!map.find(99));
+
+    assert(map.erase(ticket));
+    assert(!map.erase(ticket));
+    assert(!map.find(ticket));
+    assert(map.size() == 1);
+}
+
+void test_exceptions_are_reported_to_caller() {
+    jss::flat_combining_ticket_map<unsigned char, int> map;
+
+    for(unsigned i= 0; i < 256; ++i) {
+        map.insert(i);
+    }
+    try {
+        map.insert(-1);
+        assert(!"Should not be able to insert if ticket overflows");
+    } catch(std::overflow_error &) {
+        assert(true);
+    } catch(...) {
+        assert(!"Wrong type of exception thrown");
+    }
+    assert(map.size() == 256);
+    assert(map.find(255) == 255);
+}
+
+void test_concurrent_operations() {
+    jss::flat_combining_ticket_map<unsigned, unsigned, 8> map;
+
+    unsigned const thread_count= 8;
+    unsigned const per_thread= 2000;
+    std::vector<std::thread> threads;
+    std::vector<std::vector<unsigned>> kept(thread_count);
+
+    for(unsigned t= 0; t < thread_count; ++t) {
+        threads.emplace_back([&, t] {
+            for(unsigned i= 0; i < per_thread; ++i) {
+                auto const value= t * per_thread + i;
+                auto ticket= map.insert(value);
+                assert(map.find(ticket) == value);
+                if(i % 2) {
+                    assert(map.erase(ticket));
+                    assert(!map.find(ticket));
+                } else {
+                    kept[t].push_back(ticket);
+                }
+            }
+        });
+    }
+    for(auto &thread : threads) {
+        thread.join();
+    }
+
+    assert(map.size() == thread_count * per_thread / 2);
+    for(unsigned t= 0; t < thread_count; ++t) {
+        for(std::size_t i= 0; i < kept[t].size(); ++i) {
+            assert(map.find(kept[t][i]) == t * per_thread + i * 2);
+        }
+    }
+}
+
+void test_failed_commit_only_fails_inserts() {
+    struct failing_growth_policy : jss::default_ticket_map_policy {
+        std::atomic<bool> *fail= nullptr;
+
+        std::size_t
+        grow_capacity(std::size_t size, std::size_t) const noexcept {
+            return *fail ? std::numeric_limits<std::size_t>::max() : size * 2;
+        }
+    };
+    std::atomic<bool> fail{false};
+    failing_growth_policy policy;
+    policy.fail= &fail;
+    jss::flat_combining_ticket_map<unsigned, unsigned, 8, failing_growth_policy>
+        map(policy);
+
+    unsigned const initial= 4000;
+    for(unsigned i= 0; i < initial; ++i) {
+        map.insert(i);
+    }
+    fail= true;
+
+    unsigned const thread_count= 4;
+    std::atomic<unsigned> inserted{0};
+    std::atomic<unsigned> failed{0};
+    std::vector<std::thread> threads;
+    for(unsigned t= 0; t < thread_count; ++t) {
+        threads.emplace_back([&, t] {
+            for(unsigned i= t; i < initial; i+= thread_count) {
+                assert(map.erase(i));
+            }
+        });
+        threads.emplace_back([&] {
+            for(unsigned i= 0; i < 2000; ++i) {
+                try {
+                    map.insert(i);
+                    ++inserted;
+                } catch(std::length_error &) {
+                    ++failed;
+                }
+            }
+        });
+    }
+    for(auto &thread : threads) {
+        thread.join();
+    }
+
+    assert(failed > 0);
+    assert(map.size() == inserted);
+    for(unsigned i= 0; i < initial; ++i) {
+        assert(!map.find(i));
+    }
+}
+
+int main() {
+    test_single_threaded_operations();
+    test_exceptions_are_reported_to_caller();
+    test_concurrent_operations();
+    test_failed_commit_only_fails_inserts();
+}
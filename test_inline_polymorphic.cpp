@@ -0,0 +1,147 @@
+#include "inline_polymorphic.hpp"
+#include <assert.h>
+#include <type_traits>
+#include <string>
+#include <memory>
+
+struct Handler {
+    virtual ~Handler()= default;
+    virtual std::string handle() const= 0;
+};
+
+struct Greeter : Handler {
+    std::string name;
+
+    explicit Greeter(std::string name_) : name(std::move(name_)) {}
+    std::string handle() const override {
+        return "hello " + name;
+    }
+};
+
+struct Counter : Handler {
+    int count;
+    std::shared_ptr<int> live;
+
+    Counter(int count_, std::shared_ptr<int> live_) :
+        count(count_), live(std::move(live_)) {
+        ++*live;
+    }
+    Counter(Counter &&other) noexcept :
+        count(other.count), live(other.live) {
+        ++*live;
+    }
+    ~Counter() {
+        --*live;
+    }
+    std::string handle() const override {
+        return std::to_string(count);
+    }
+};
+
+struct Tagged {
+    virtual ~Tagged()= default;
+    long long tag= 7;
+};
+
+struct TaggedGreeter : Tagged, Handler {
+    std::string handle() const override {
+        return "tag " + std::to_string(tag);
+    }
+};
+
+using handler_map= jss::inline_polymorphic_ticket_map<int, Handler, 64>;
+
+void test_values_are_stored_inline() {
+    static_assert(
+        sizeof(jss::inline_polymorphic<Handler, 64>) <=
+        64 + sizeof(void *) + alignof(std::max_align_t));
+
+    handler_map map;
+
+    auto greeter= map.emplace(std::in_place_type<Greeter>, "world");
+    auto counter= map.emplace(
+        std::in_place_type<Counter>, 42, std::make_shared<int>(0));
+
+    assert(map[greeter]->handle() == "hello world");
+    assert(map[counter]->handle() == "42");
+    assert(dynamic_cast<Greeter &>(map[greeter].get()).name == "world");
+
+    auto const &cmap= map;
+    static_assert(
+        std::is_same_v<decltype(cmap[greeter].get()), Handler const &>);
+    assert((*cmap[counter]).handle() == "42");
+
+    auto *storage= reinterpret_cast<char const *>(&map[greeter]);
+    auto *object= reinterpret_cast<char const *>(&map[greeter].get());
+    assert(object >= storage);
+    assert(object < storage + sizeof(map[greeter]));
+}
+
+void test_objects_survive_compaction_and_are_destroyed() {
+    auto live= std::make_shared<int>(0);
+
+    {
+        handler_map map;
+        for(int i= 0; i < 100; ++i) {
+            if(i % 2)
+                map.emplace(std::in_place_type<Counter>, i, live);
+            else
+                map.emplace(std::in_place_type<Greeter>, std::to_string(i));
+        }
+        assert(*live == 50);
+
+        for(int i= 0; i < 80; ++i) {
+            map.erase(i);
+        }
+        assert(*live == 10);
+
+        for(auto &e : map) {
+            if(e.ticket % 2)
+                assert(e.value->handle() == std::to_string(e.ticket));
+            else
+                assert(
+                    e.value->handle() == "hello " + std::to_string(e.ticket));
+        }
+
+        map.shrink_to_fit();
+        assert(*live == 10);
+        assert(map[81]->handle() == "81");
+    }
+    assert(*live == 0);
+}
+
+void test_move_assignment_replaces_object() {
+    auto live= std::make_shared<int>(0);
+    jss::inline_polymorphic<Handler, 64> a(
+        std::in_place_type<Counter>, 1, live);
+    jss::inline_polymorphic<Handler, 64> b(std::in_place_type<Greeter>, "b");
+
+    b= std::move(a);
+    assert(b->handle() == "1");
+    assert(*live == 2);
+
+    a= std::move(b);
+    assert(a->handle() == "1");
+}
+
+void test_base_not_at_start_of_derived() {
+    jss::inline_polymorphic<Handler, 64> a(std::in_place_type<TaggedGreeter>);
+    auto &derived= dynamic_cast<TaggedGreeter &>(a.get());
+    assert(
+        static_cast<void *>(&derived) != static_cast<void *>(&a.get()));
+    assert(a->handle() == "tag 7");
+
+    jss::inline_polymorphic<Handler, 64> b(std::in_place_type<Greeter>, "b");
+    b= std::move(a);
+    assert(b->handle() == "tag 7");
+    jss::inline_polymorphic<Handler, 64> c(std::move(b));
+    assert(c->handle() == "tag 7");
+    assert(dynamic_cast<TaggedGreeter &>(c.get()).tag == 7);
+}
+
+int main() {
+    test_values_are_stored_inline();
+    test_objects_survive_compaction_and_are_destroyed();
+    test_move_assignment_replaces_object();
+    test_base_not_at_start_of_derived();
+}
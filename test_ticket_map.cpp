@@ -3,6 +3,10 @@
 #include <type_traits>
 #include <string>
 #include <iostream>
+#include <thread>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
 
 void test_initially_empty() {
     jss::ticket_map<int, int> map;
@@ -700,6 +704,736 @@ void test_count() {
     assert(!map.count(1));
 }
 
+void test_shrink_to_fit_releases_unused_memory() {
+    jss::ticket_map<int, int> map;
+
+    unsigned const count= 100;
+    for(unsigned i= 0; i < count; ++i) {
+        map.insert(i);
+    }
+    for(unsigned i= 0; i < count; i+= 2) {
+        map.erase(i);
+    }
+
+    assert(map.capacity() > map.size());
+
+    map.shrink_to_fit();
+
+    assert(map.size() == count / 2);
+    assert(map.capacity() == map.size());
+    for(unsigned i= 1; i < count; i+= 2) {
+        assert(map[i] == i);
+    }
+    assert(map.insert(42) == count);
+}
+
+void test_default_policy_keeps_capacity() {
+    jss::ticket_map<int, int> map;
+
+    unsigned const count= 1000;
+    for(unsigned i= 0; i < count; ++i) {
+        map.insert(i);
+    }
+    auto const peak= map.capacity();
+
+    for(unsigned i= 0; i < count - 1; ++i) {
+        map.erase(i);
+    }
+    assert(map.capacity() == peak);
+
+    map.clear();
+    assert(map.capacity() == peak);
+}
+
+void test_release_memory_policy_shrinks_after_erase() {
+    jss::ticket_map<int, int, jss::release_memory_policy<4, 16>> map;
+
+    unsigned const count= 1000;
+    for(unsigned i= 0; i < count; ++i) {
+        map.insert(i);
+    }
+    auto const peak= map.capacity();
+
+    auto iter= map.begin();
+    for(unsigned i= 0; i < count - 10; ++i) {
+        iter= map.erase(iter);
+        assert(map.capacity() <= std::max<std::size_t>(map.size() * 4, peak));
+    }
+    assert(iter == map.begin());
+    assert(iter->ticket == count - 10);
+
+    assert(map.size() == 10);
+    assert(map.capacity() < 4 * 16);
+    unsigned val= count - 10;
+    for(auto &e : map) {
+        assert(e.value == val);
+        ++val;
+    }
+
+    map.clear();
+    assert(map.capacity() <= 16);
+    assert(map.insert(42) == count);
+}
+
+void test_release_memory_policy_does_not_thrash() {
+    jss::ticket_map<int, int, jss::release_memory_policy<4, 16>> map;
+
+    for(unsigned i= 0; i < 100; ++i) {
+        map.insert(i);
+    }
+    for(unsigned i= 0; i < 80; ++i) {
+        map.erase(i);
+    }
+    auto const capacity= map.capacity();
+    assert(capacity < 100);
+
+    for(unsigned i= 0; i < 10; ++i) {
+        map.erase(map.insert(i));
+    }
+    assert(map.capacity() == capacity);
+}
+
+void test_deferred_compaction_policy_keeps_empty_slots() {
+    jss::ticket_map<int, int, jss::deferred_compaction_policy<>> map;
+
+    for(unsigned i= 0; i < 100; ++i) {
+        map.insert(i);
+    }
+    for(unsigned i= 0; i < 90; ++i) {
+        map.erase(i);
+    }
+    assert(map.size() == 10);
+    assert(map.tickets().size() == 100);
+    assert(map[95] == 95);
+
+    map.reserve(10);
+    assert(map.tickets().size() == 10);
+    assert(map[95] == 95);
+}
+
+void test_compaction_threshold_policy() {
+    jss::ticket_map<int, int, jss::compaction_threshold_policy<1, 4>> map;
+
+    for(unsigned i= 0; i < 100; ++i) {
+        map.insert(i);
+    }
+    for(unsigned i= 0; i < 75; ++i) {
+        map.erase(i);
+    }
+    assert(map.tickets().size() == 100);
+
+    map.erase(75);
+    assert(map.size() == 24);
+    assert(map.tickets().size() == 24);
+    assert(map[99] == 99);
+}
+
+void test_growth_factor_policy() {
+    jss::ticket_map<int, int, jss::growth_factor_policy<3, 2>> map;
+    jss::ticket_map<int, int> doubling;
+
+    for(unsigned i= 0; i < 100; ++i) {
+        map.insert(i);
+        doubling.insert(i);
+    }
+    assert(map.size() == 100);
+    assert(map.capacity() == 141);
+    assert(doubling.capacity() == 128);
+    assert(map[99] == 99);
+}
+
+void test_batch_lookups_see_pending_state() {
+    jss::ticket_map<int, std::string> map;
+
+    auto first= map.insert("first");
+    auto second= map.insert("second");
+
+    {
+        auto batch= map.batch();
+        auto third= batch.insert("third");
+        assert(third == 2);
+        assert(batch.erase(first));
+        assert(!batch.erase(first));
+        assert(batch.count(third) == 1);
+        assert(batch.count(first) == 0);
+        assert(batch[third] == "third");
+        assert(batch[second] == "second");
+        assert(batch.size() == 2);
+
+        auto fourth= batch.emplace(3, 'x');
+        assert(batch.erase(fourth));
+        assert(!batch.count(fourth));
+        assert(batch.size() == 2);
+
+        assert(!map.count(third));
+    }
+
+    assert(map.size() == 2);
+    assert(!map.count(first));
+    assert(map[second] == "second");
+    assert(map[2] == "third");
+    assert(!map.count(3));
+    assert(map.insert("fifth") == 4);
+
+    unsigned count= 0;
+    for(auto &e : map) {
+        assert(e.ticket > 0);
+        ++count;
+    }
+    assert(count == 3);
+}
+
+void test_batch_commit_reallocates_at_most_once() {
+    struct MoveCounter {
+        unsigned count;
+
+        MoveCounter(unsigned) : count(0) {}
+        MoveCounter(MoveCounter &&other) : count(other.count + 1) {}
+        MoveCounter &operator=(MoveCounter &&other) {
+            count= other.count + 1;
+            return *this;
+        }
+    };
+
+    jss::ticket_map<int, MoveCounter> map;
+    for(unsigned i= 0; i < 100; ++i) {
+        map.emplace(i);
+    }
+    for(auto &e : map) {
+        e.value.count= 0;
+    }
+
+    auto batch= map.batch();
+    for(unsigned i= 0; i < 100; i+= 2) {
+        batch.erase(i);
+    }
+    for(unsigned i= 0; i < 1000; ++i) {
+        batch.emplace(i);
+    }
+    batch.commit();
+    batch.commit();
+
+    assert(map.size() == 1050);
+    assert(map.capacity() >= 1050);
+    for(auto &e : map) {
+        if(e.ticket < 100) {
+            assert(e.ticket % 2);
+            assert(e.value.count == 1);
+        }
+    }
+}
+
+/// A value whose move constructor throws when moves_until_throw reaches zero
+struct ThrowingMove {
+    static inline int moves_until_throw= -1;
+
+    int value;
+
+    ThrowingMove(int value_) : value(value_) {}
+    ThrowingMove(ThrowingMove &&other) : value(other.value) {
+        if(moves_until_throw >= 0 && !moves_until_throw--)
+            throw std::runtime_error("move failed");
+    }
+    ThrowingMove &operator=(ThrowingMove &&other) noexcept {
+        value= other.value;
+        return *this;
+    }
+};
+
+void test_batch_destructor_discards_failed_commit() {
+    jss::ticket_map<int, ThrowingMove> map;
+    for(int i= 0; i < 4; ++i) {
+        map.emplace(i);
+    }
+
+    {
+        auto batch= map.batch();
+        for(int i= 0; i < 100; ++i) {
+            batch.emplace(i);
+        }
+        ThrowingMove::moves_until_throw= 0;
+    }
+    ThrowingMove::moves_until_throw= -1;
+
+    assert(map.size() == 4);
+    for(int i= 0; i < 4; ++i) {
+        assert(map[i].value == i);
+    }
+}
+
+void test_failed_batch_commit_discards_pending_inserts() {
+    jss::ticket_map<int, ThrowingMove> map;
+    map.reserve(100);
+    map.enable_order_statistics();
+    for(int i= 0; i < 4; ++i) {
+        map.emplace(i);
+    }
+
+    auto batch= map.batch();
+    batch.erase(1);
+    for(int i= 0; i < 10; ++i) {
+        batch.emplace(i);
+    }
+    ThrowingMove::moves_until_throw= 5;
+    try {
+        batch.commit();
+        assert(!"Should throw");
+    } catch(std::runtime_error &) {
+    }
+    ThrowingMove::moves_until_throw= -1;
+
+    assert(map.size() == 3);
+    assert(!map.count(1));
+    assert(!map.count(4));
+    assert(map.tickets().size() == 4);
+    assert(map.rank(3) == 2);
+    assert(map.emplace(20) == 14);
+    assert(map.size() == 4);
+}
+
+void test_release_memory_policy_keeps_storage_if_move_can_throw() {
+    jss::ticket_map<
+        int, ThrowingMove,
+        jss::release_memory_policy<4, 16, jss::deferred_compaction_policy<>>>
+        map;
+    for(int i= 0; i < 100; ++i) {
+        map.emplace(i);
+    }
+    auto const capacity= map.capacity();
+
+    ThrowingMove::moves_until_throw= 0;
+    for(int i= 0; i < 90; ++i) {
+        map.erase(i);
+    }
+    map.clear();
+    ThrowingMove::moves_until_throw= -1;
+
+    assert(map.empty());
+    assert(map.capacity() == capacity);
+}
+
+void test_failed_insert_with_ticket_does_not_consume_ticket() {
+    jss::ticket_map<int, ThrowingMove> map;
+    map.emplace(0);
+
+    ThrowingMove::moves_until_throw= 0;
+    try {
+        map.insert_with_ticket(10, ThrowingMove(10));
+        assert(!"Should throw");
+    } catch(std::runtime_error &) {
+    }
+    ThrowingMove::moves_until_throw= -1;
+
+    assert(map.size() == 1);
+    assert(!map.count(10));
+    assert(map.tickets().size() == 1);
+    map.insert_with_ticket(5, ThrowingMove(5));
+    assert(map.insert(ThrowingMove(6)) == 6);
+    int previous= -1;
+    for(auto &entry : map) {
+        assert(entry.ticket > previous);
+        assert(entry.value.value == entry.ticket);
+        previous= entry.ticket;
+    }
+    assert(previous == 6);
+}
+
+void test_reserved_ticket_is_not_present_until_fulfilled() {
+    jss::ticket_map<int, std::string> map;
+
+    map.insert("first");
+    auto ticket= map.reserve_ticket();
+    assert(ticket == 1);
+    assert(map.reserved_count() == 1);
+    auto after= map.insert("third");
+    assert(after == 2);
+
+    assert(map.size() == 2);
+    assert(!map.count(ticket));
+    assert(map.find(ticket) == map.end());
+    assert(map.erase(ticket) == map.end());
+
+    auto iter= map.fulfil(ticket, 3, 'x');
+    assert(iter->ticket == ticket);
+    assert(iter->value == "xxx");
+    assert(map[ticket] == "xxx");
+    assert(map.size() == 3);
+    assert(map.reserved_count() == 0);
+
+    try {
+        map.fulfil(ticket, "again");
+        assert(!"Should throw");
+    } catch(std::out_of_range &) {
+        assert(true);
+    } catch(...) {
+        assert(!"Should throw out-of-range");
+    }
+
+    int expected= 0;
+    for(auto &e : map) {
+        assert(e.ticket == expected++);
+    }
+    assert(expected == 3);
+}
+
+void test_reservations_survive_compaction() {
+    jss::ticket_map<int, int> map;
+
+    std::vector<int> reserved;
+    for(unsigned i= 0; i < 100; ++i) {
+        map.insert(i);
+        if(i % 10 == 0)
+            reserved.push_back(map.reserve_ticket());
+    }
+    for(int i= 0; i < 210; ++i) {
+        map.erase(i);
+    }
+    map.shrink_to_fit();
+    assert(map.size() == 0);
+    assert(map.capacity() == reserved.size());
+    assert(map.reserved_count() == reserved.size());
+
+    for(unsigned i= 0; i < 1000; ++i) {
+        map.erase(map.insert(i));
+    }
+
+    assert(map.cancel_reservation(reserved.back()));
+    assert(!map.cancel_reservation(reserved.back()));
+    reserved.pop_back();
+
+    for(auto ticket : reserved) {
+        map.fulfil(ticket, ticket * 2);
+    }
+    assert(map.size() == reserved.size());
+    auto expected= reserved.begin();
+    for(auto &e : map) {
+        assert(e.ticket == *expected);
+        assert(e.value == *expected * 2);
+        ++expected;
+    }
+}
+
+void test_insert_with_ticket_advances_next_ticket() {
+    jss::ticket_map<int, std::string> map;
+
+    map.insert("first");
+    auto iter= map.insert_with_ticket(10, "tenth");
+    assert(iter->ticket == 10);
+    assert(iter->value == "tenth");
+    assert(map.insert("next") == 11);
+    map.insert_with_ticket(20, "twentieth");
+    assert(map.size() == 4);
+    assert(map[20] == "twentieth");
+
+    try {
+        map.insert_with_ticket(20, "again");
+        assert(!"Should throw");
+    } catch(std::invalid_argument &) {
+        assert(true);
+    } catch(...) {
+        assert(!"Should throw invalid_argument");
+    }
+    try {
+        map.insert_with_ticket(5, "earlier");
+        assert(!"Should throw");
+    } catch(std::invalid_argument &) {
+        assert(true);
+    } catch(...) {
+        assert(!"Should throw invalid_argument");
+    }
+    assert(map.size() == 4);
+    assert(map.insert("last") == 21);
+}
+
+void test_insert_with_ticket_can_overflow() {
+    jss::ticket_map<unsigned char, int> map;
+
+    map.insert_with_ticket(255, 42);
+    assert(map[255] == 42);
+    try {
+        map.insert(-1);
+        assert(!"Should not be able to insert if ticket overflows");
+    } catch(std::overflow_error &) {
+        assert(true);
+    } catch(...) {
+        assert(!"Wrong type of exception thrown");
+    }
+}
+
+void test_assign_sorted_replaces_contents() {
+    jss::ticket_map<int, std::string> map;
+
+    map.insert("old");
+    std::vector<std::pair<int, std::string>> const saved= {
+        {3, "three"}, {7, "seven"}, {8, "eight"}, {100, "hundred"}};
+
+    map.assign_sorted(saved.begin(), saved.end());
+    assert(map.size() == saved.size());
+    assert(!map.count(0));
+    auto expected= saved.begin();
+    for(auto &e : map) {
+        assert(e.ticket == expected->first);
+        assert(e.value == expected->second);
+        ++expected;
+    }
+    assert(map.insert("new") == 101);
+
+    std::vector<std::pair<int, std::string>> const unsorted= {
+        {3, "three"}, {3, "three again"}};
+    try {
+        map.assign_sorted(unsorted.begin(), unsorted.end());
+        assert(!"Should throw");
+    } catch(std::invalid_argument &) {
+        assert(true);
+    } catch(...) {
+        assert(!"Should throw invalid_argument");
+    }
+    assert(map.size() == saved.size() + 1);
+
+    map.assign_sorted(saved.begin(), saved.begin() + 1);
+    assert(map.size() == 1);
+    assert(map[3] == "three");
+    assert(map.insert("newer") == 102);
+}
+
+template <typename Map> void check_rank_and_select(Map &map) {
+    std::vector<int> live;
+    for(auto &e : map) {
+        live.push_back(e.ticket);
+    }
+    assert(map.select(live.size()) == map.end());
+    for(std::size_t k= 0; k < live.size(); ++k) {
+        assert(map.rank(live[k]) == k);
+        assert(map.rank(live[k] + 1) == k + 1);
+        auto iter= map.select(k);
+        assert(iter != map.end());
+        assert(iter->ticket == live[k]);
+    }
+}
+
+void test_rank_and_select() {
+    jss::ticket_map<int, int> map;
+    assert(map.rank(0) == 0);
+    assert(map.select(0) == map.end());
+
+    for(unsigned i= 0; i < 100; ++i) {
+        map.insert(i);
+    }
+    for(unsigned i= 0; i < 100; i+= 3) {
+        map.erase(i);
+    }
+    assert(map.rank(1000) == map.size());
+    check_rank_and_select(map);
+
+    map.enable_order_statistics();
+    check_rank_and_select(map);
+
+    for(unsigned i= 0; i < 100; ++i) {
+        map.insert(i);
+        if(i % 5 == 0)
+            map.erase(i + 1);
+        if(i % 7 == 0)
+            map.reserve_ticket();
+    }
+    check_rank_and_select(map);
+
+    for(unsigned i= 0; i < 160; ++i) {
+        map.erase(i);
+    }
+    check_rank_and_select(map);
+
+    {
+        auto batch= map.batch();
+        batch.erase(200);
+        for(unsigned i= 0; i < 50; ++i) {
+            batch.insert(i);
+        }
+    }
+    check_rank_and_select(map);
+
+    auto const &cmap= map;
+    assert(cmap.select(3)->ticket == map.select(3)->ticket);
+
+    map.shrink_to_fit();
+    check_rank_and_select(map);
+    map.clear();
+    check_rank_and_select(map);
+    map.insert(1);
+    check_rank_and_select(map);
+}
+
+void test_slot_views() {
+    jss::ticket_map<int, int> map;
+
+    for(unsigned i= 0; i < 20; ++i) {
+        map.insert(i * 10);
+    }
+    map.erase(3);
+    map.erase(4);
+    map.erase(10);
+    map.erase(19);
+
+    auto tickets= map.tickets();
+    auto values= map.values();
+    auto occupancy= map.occupancy();
+    assert(tickets.size() == 20);
+    assert(values.size() == 20);
+    assert(occupancy.size() == 20);
+
+    int sum= 0;
+    for(std::size_t i= 0; i < tickets.size(); ++i) {
+        assert(tickets[i] == i);
+        assert(occupancy[i] == map.count(i));
+        if(occupancy[i]) {
+            assert(values[i] == i * 10);
+            sum+= values[i];
+        }
+    }
+
+    values[0]= 42;
+    assert(map[0] == 42);
+
+    std::size_t index= 0;
+    for(auto ticket : tickets) {
+        assert(ticket == index++);
+    }
+    assert(tickets.subview(5, 3)[0] == 5);
+    assert(tickets.subview(5, 3).size() == 3);
+
+    std::vector<std::pair<int, std::size_t>> runs;
+    int run_sum= 0;
+    for(auto run : map.dense_runs()) {
+        assert(run.tickets.size() == run.values.size());
+        assert(!run.values.empty());
+        runs.emplace_back(run.tickets[0], run.tickets.size());
+        for(auto &v : run.values) {
+            run_sum+= v;
+        }
+    }
+    assert(run_sum == sum - 0 + 42);
+    std::vector<std::pair<int, std::size_t>> const expected= {
+        {0, 3}, {5, 5}, {11, 8}};
+    assert(runs == expected);
+
+    auto const &cmap= map;
+    static_assert(
+        std::is_same_v<decltype(cmap.values()[0]), int const &>);
+    static_assert(
+        std::is_same_v<decltype((*cmap.dense_runs().begin()).values[0]),
+                       int const &>);
+
+    jss::ticket_map<int, int> empty;
+    assert(empty.dense_runs().begin() == empty.dense_runs().end());
+    assert(empty.tickets().empty());
+}
+
+void test_bulk_load_from_several_threads() {
+    jss::ticket_map<unsigned, std::string> map;
+    map.insert("existing");
+
+    std::vector<std::size_t> const counts{1000, 0, 2500, 1};
+    auto loader= map.bulk_load(counts);
+    assert(loader.size() == 4);
+    assert(loader[0].next_ticket() == 1);
+    assert(loader[2].next_ticket() == 1001);
+    assert(loader[3].next_ticket() == 3501);
+
+    std::vector<std::thread> producers;
+    for(std::size_t p= 0; p < counts.size(); ++p) {
+        producers.emplace_back([&, p] {
+            auto &region= loader[p];
+            for(std::size_t i= 0; i < counts[p]; ++i) {
+                auto const ticket= region.next_ticket();
+                assert(region.emplace_back(std::to_string(ticket)) == ticket);
+            }
+            assert(region.size() == region.capacity());
+        });
+    }
+    for(auto &producer : producers) {
+        producer.join();
+    }
+    loader.commit();
+
+    assert(map.size() == 3502);
+    assert(map[0] == "existing");
+    unsigned expected= 0;
+    for(auto const &entry : map) {
+        assert(entry.ticket == expected);
+        if(expected)
+            assert(entry.value == std::to_string(expected));
+        ++expected;
+    }
+    assert(map.insert("next") == 3502);
+}
+
+void test_bulk_load_leaves_unfilled_slots_empty() {
+    jss::ticket_map<int, int> map;
+
+    {
+        auto loader= map.bulk_load({3, 3});
+        loader[0].push_back(0);
+        loader[1].push_back(3);
+        loader[1].push_back(4);
+        try {
+            loader[1].push_back(5);
+            loader[1].push_back(6);
+            assert(!"Should not be able to overfill a region");
+        } catch(std::length_error &) {
+            assert(true);
+        }
+        loader.commit();
+    }
+
+    assert(map.size() == 4);
+    assert(map.count(0));
+    assert(!map.count(1));
+    assert(!map.count(2));
+    assert(map[5] == 5);
+    assert(map.insert(6) == 6);
+}
+
+void test_abandoned_bulk_load_leaves_map_unchanged() {
+    jss::ticket_map<int, std::string> map;
+    map.insert("first");
+
+    {
+        auto loader= map.bulk_load({2});
+        loader[0].push_back("lost");
+    }
+
+    assert(map.size() == 1);
+    assert(map.tickets().size() == 1);
+    assert(map.insert("second") == 1);
+}
+
+void test_bulk_load_checks_for_overflow() {
+    jss::ticket_map<unsigned char, int> map;
+
+    try {
+        map.bulk_load({200, 57});
+        assert(!"Should not be able to load more values than tickets");
+    } catch(std::overflow_error &) {
+        assert(true);
+    }
+    assert(map.empty());
+
+    {
+        auto loader= map.bulk_load({200, 56});
+        for(unsigned i= 0; i < 256; ++i) {
+            loader[i < 200 ? 0 : 1].push_back(i);
+        }
+        loader.commit();
+    }
+    assert(map.size() == 256);
+    assert(map[255] == 255);
+    try {
+        map.insert(0);
+        assert(!"Should not be able to insert once tickets overflowed");
+    } catch(std::overflow_error &) {
+        assert(true);
+    }
+}
+
 int main() {
     test_initially_empty();
     test_inserting_a_value_gives_ticket_for_new_element();
@@ -731,4 +1465,28 @@ int main() {
     test_count();
     test_cannot_overflow_signed();
     test_cannot_overflow_custom();
+    test_shrink_to_fit_releases_unused_memory();
+    test_default_policy_keeps_capacity();
+    test_release_memory_policy_shrinks_after_erase();
+    test_release_memory_policy_does_not_thrash();
+    test_release_memory_policy_keeps_storage_if_move_can_throw();
+    test_deferred_compaction_policy_keeps_empty_slots();
+    test_compaction_threshold_policy();
+    test_growth_factor_policy();
+    test_batch_lookups_see_pending_state();
+    test_batch_commit_reallocates_at_most_once();
+    test_batch_destructor_discards_failed_commit();
+    test_failed_batch_commit_discards_pending_inserts();
+    test_reserved_ticket_is_not_present_until_fulfilled();
+    test_reservations_survive_compaction();
+    test_insert_with_ticket_advances_next_ticket();
+    test_insert_with_ticket_can_overflow();
+    test_failed_insert_with_ticket_does_not_consume_ticket();
+    test_assign_sorted_replaces_contents();
+    test_rank_and_select();
+    test_slot_views();
+    test_bulk_load_from_several_threads();
+    test_bulk_load_leaves_unfilled_slots_empty();
+    test_abandoned_bulk_load_leaves_map_unchanged();
+    test_bulk_load_checks_for_overflow();
 }
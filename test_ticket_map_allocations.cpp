@@ -0,0 +1,242 @@
+#include "ticket_map.hpp"
+#include <assert.h>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#ifdef _MSC_VER
+#include <malloc.h>
+#else
+#include <stdlib.h>
+#endif
+
+namespace {
+    /// The number of calls to the global operator new so far
+    std::atomic<std::size_t> allocations{0};
+
+    /// Return the number of allocations made by calling f
+    template <typename F> std::size_t allocations_during(F f) {
+        auto const before= allocations.load();
+        f();
+        return allocations.load() - before;
+    }
+
+    /// Allocate size bytes aligned to alignment, or return nullptr.
+    /// std::aligned_alloc is not available everywhere, so use the platform
+    /// function.
+    void *aligned_allocate(std::size_t size, std::size_t alignment) noexcept {
+#ifdef _MSC_VER
+        return _aligned_malloc(size ? size : 1, alignment);
+#else
+        if(alignment < sizeof(void *))
+            alignment= sizeof(void *);
+        void *p= nullptr;
+        return posix_memalign(&p, alignment, size ? size : 1) ? nullptr : p;
+#endif
+    }
+
+    /// Free memory allocated with aligned_allocate
+    void aligned_free(void *p) noexcept {
+#ifdef _MSC_VER
+        _aligned_free(p);
+#else
+        free(p);
+#endif
+    }
+} // namespace
+
+void *operator new(std::size_t size) {
+    ++allocations;
+    if(auto p= std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, std::align_val_t align) {
+    ++allocations;
+    if(auto p= aligned_allocate(size, static_cast<std::size_t>(align)))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, std::align_val_t) noexcept {
+    aligned_free(p);
+}
+
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept {
+    aligned_free(p);
+}
+
+void test_counting_allocator_sees_allocations() {
+    // Call the allocation functions directly, as the compiler may elide a
+    // new-expression paired with a delete-expression
+    assert(allocations_during([] {
+               ::operator delete(::operator new(sizeof(int)));
+           }) == 1);
+    assert(allocations_during([] {
+               auto const align= std::align_val_t(64);
+               ::operator delete(::operator new(64, align), align);
+           }) == 1);
+    assert(allocations_during([] {
+               jss::ticket_map<int, int> map;
+               map.insert(1);
+           }) == 1);
+}
+
+void test_steady_state_operations_do_not_allocate() {
+    jss::ticket_map<unsigned, unsigned> map;
+    map.reserve(1000);
+    for(unsigned i= 0; i < 750; ++i) {
+        map.insert(i);
+    }
+    unsigned oldest= 0;
+
+    assert(allocations_during([&] {
+               for(unsigned i= 0; i < 100000; ++i) {
+                   auto ticket= map.emplace(i);
+                   assert(map.find(ticket)->value == i);
+                   assert(map[ticket] == i);
+                   assert(map.count(oldest));
+                   map.erase(oldest++);
+               }
+           }) == 0);
+    assert(map.size() == 750);
+}
+
+void test_compaction_does_not_allocate() {
+    jss::ticket_map<unsigned, int> map;
+    for(unsigned i= 0; i < 1000; ++i) {
+        map.insert(i);
+    }
+    auto const capacity= map.capacity();
+
+    assert(allocations_during([&] {
+               for(unsigned i= 0; i < 900; ++i) {
+                   map.erase(i);
+               }
+               map.reserve(50);
+           }) == 0);
+    assert(map.tickets().size() == 100);
+    assert(map.capacity() == capacity);
+}
+
+void test_reserve_within_capacity_does_not_allocate() {
+    jss::ticket_map<unsigned, int> map;
+    map.reserve(100);
+    for(unsigned i= 0; i < 80; ++i) {
+        map.insert(i);
+    }
+    for(unsigned i= 0; i < 30; ++i) {
+        map.erase(i);
+    }
+
+    assert(allocations_during([&] {
+               map.reserve(100);
+               map.reserve(60);
+               map.reserve(10);
+           }) == 0);
+    assert(map.capacity() == 100);
+    assert(map.insert_capacity() == 50);
+}
+
+void test_iteration_and_views_do_not_allocate() {
+    jss::ticket_map<unsigned, int> map;
+    for(unsigned i= 0; i < 100; ++i) {
+        map.insert(i);
+    }
+    for(unsigned i= 0; i < 100; i+= 3) {
+        map.erase(i);
+    }
+
+    assert(allocations_during([&] {
+               long sum= 0;
+               for(auto &entry : map) {
+                   sum+= entry.value;
+               }
+               for(auto &entry : std::as_const(map)) {
+                   sum-= entry.value;
+               }
+               auto const tickets= map.tickets();
+               auto const values= map.values();
+               auto const occupancy= map.occupancy();
+               for(std::size_t i= 0; i < tickets.size(); ++i) {
+                   if(occupancy[i])
+                       sum+= values[i] - tickets[i];
+               }
+               for(auto run : map.dense_runs()) {
+                   for(auto value : run.values) {
+                       sum+= value;
+                   }
+               }
+               assert(sum > 0);
+           }) == 0);
+}
+
+void test_order_statistics_do_not_allocate_once_reserved() {
+    jss::ticket_map<unsigned, int> map;
+    map.enable_order_statistics();
+    map.reserve(1000);
+    for(unsigned i= 0; i < 500; ++i) {
+        map.insert(i);
+    }
+    unsigned oldest= 0;
+
+    assert(allocations_during([&] {
+               for(unsigned i= 0; i < 10000; ++i) {
+                   map.insert(i);
+                   map.erase(oldest++);
+                   assert(map.rank(oldest) == 0);
+                   assert(map.select(0)->ticket == oldest);
+               }
+           }) == 0);
+}
+
+void test_erase_only_batch_does_not_allocate() {
+    jss::ticket_map<unsigned, int> map;
+    for(unsigned i= 0; i < 100; ++i) {
+        map.insert(i);
+    }
+
+    assert(allocations_during([&] {
+               auto batch= map.batch();
+               for(unsigned i= 0; i < 100; i+= 2) {
+                   batch.erase(i);
+               }
+           }) == 0);
+    assert(map.size() == 50);
+}
+
+void test_batch_grows_storage_once_despite_reservations() {
+    jss::ticket_map<unsigned, int, jss::growth_factor_policy<101, 100>> map;
+    for(unsigned i= 0; i < 10; ++i) {
+        map.insert(i);
+    }
+    for(unsigned i= 0; i < 5; ++i) {
+        map.reserve_ticket();
+    }
+
+    auto batch= map.batch();
+    for(unsigned i= 0; i < 100; ++i) {
+        batch.insert(i);
+    }
+    assert(allocations_during([&] { batch.commit(); }) == 1);
+    assert(map.size() == 110);
+}
+
+int main() {
+    test_counting_allocator_sees_allocations();
+    test_steady_state_operations_do_not_allocate();
+    test_compaction_does_not_allocate();
+    test_reserve_within_capacity_does_not_allocate();
+    test_iteration_and_views_do_not_allocate();
+    test_order_statistics_do_not_allocate_once_reserved();
+    test_erase_only_batch_does_not_allocate();
+    test_batch_grows_storage_once_despite_reservations();
+}
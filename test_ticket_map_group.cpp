@@ -0,0 +1,111 @@
+#include "ticket_map_group.hpp"
+#include <assert.h>
+#include <type_traits>
+#include <string>
+#include <vector>
+
+struct Stats {
+    unsigned requests= 0;
+};
+
+using session_group=
+    jss::ticket_map_group<int, std::string, Stats, std::vector<char>>;
+
+void test_insert_row_gives_one_ticket_for_all_columns() {
+    session_group group;
+
+    auto ticket= group.insert("alice", Stats{3}, std::vector<char>(10));
+    auto ticket2= group.insert("bob", Stats{5}, std::vector<char>());
+    assert(ticket == 0);
+    assert(ticket2 == 1);
+    assert(group.size() == 2);
+
+    assert(group.get<0>(ticket) == "alice");
+    assert(group.get<1>(ticket).requests == 3);
+    assert(group.get<2>(ticket).size() == 10);
+    assert(group.get<0>(ticket2) == "bob");
+}
+
+void test_single_lookup_resolves_all_columns() {
+    session_group group;
+
+    auto ticket= group.insert("alice", Stats{3}, std::vector<char>(10));
+
+    auto [name, stats, buffer]= group.fields(ticket);
+    static_assert(std::is_same_v<decltype(name), std::string &>);
+    ++stats.requests;
+    buffer.push_back('x');
+    assert(name == "alice");
+    assert(group.get<1>(ticket).requests == 4);
+    assert(group.get<2>(ticket).size() == 11);
+
+    auto const &cgroup= group;
+    auto [cname, cstats, cbuffer]= cgroup.fields(ticket);
+    static_assert(std::is_same_v<decltype(cname), std::string const &>);
+    assert(cstats.requests == 4);
+
+    try {
+        group.fields(ticket + 1);
+        assert(!"Should throw");
+    } catch(std::out_of_range &) {
+        assert(true);
+    } catch(...) {
+        assert(!"Should throw out-of-range");
+    }
+}
+
+void test_columns_iterate_independently() {
+    session_group group;
+
+    for(unsigned i= 0; i < 20; ++i) {
+        group.insert(std::to_string(i), Stats{i}, std::vector<char>(i));
+    }
+    group.erase(3);
+    group.erase(7);
+
+    unsigned total= 0;
+    std::size_t rows= 0;
+    for(auto e : group.entries<1>()) {
+        static_assert(std::is_same_v<decltype(e.value), Stats &>);
+        assert(e.value.requests == e.ticket);
+        total+= e.value.requests;
+        ++rows;
+    }
+    assert(rows == group.size());
+    assert(total == 190 - 3 - 7);
+
+    auto const &cgroup= group;
+    rows= 0;
+    for(auto e : cgroup.entries<0>()) {
+        static_assert(std::is_same_v<decltype(e.value), std::string const &>);
+        assert(e.value == std::to_string(e.ticket));
+        ++rows;
+    }
+    assert(rows == group.size());
+}
+
+void test_erase_removes_all_columns_together() {
+    session_group group;
+
+    for(unsigned i= 0; i < 100; ++i) {
+        group.insert(std::to_string(i), Stats{i}, std::vector<char>(i));
+    }
+    for(int i= 0; i < 90; ++i) {
+        group.erase(i);
+    }
+    assert(group.size() == 10);
+    assert(group.tickets().size() < 100);
+    assert(group.column<2>().size() == group.tickets().size());
+
+    for(auto e : group) {
+        assert(e.value.get<0>() == std::to_string(e.ticket));
+        assert(e.value.get<2>().size() == e.ticket);
+    }
+}
+
+int main() {
+    test_insert_row_gives_one_ticket_for_all_columns();
+    test_single_lookup_resolves_all_columns();
+    test_columns_iterate_independently();
+    test_erase_removes_all_columns_together();
+}
@@ -0,0 +1,136 @@
+#include "ticket_map_join.hpp"
+#include <assert.h>
+#include <type_traits>
+#include <string>
+#include <vector>
+
+using request_map= jss::ticket_map<int, std::string>;
+using response_map= jss::ticket_map<int, int>;
+
+/// Fill the maps with the same tickets, then erase to leave the specified
+/// tickets in each
+void fill(
+    request_map &requests, response_map &responses,
+    std::vector<int> const &request_tickets,
+    std::vector<int> const &response_tickets, int count) {
+    for(int i= 0; i < count; ++i) {
+        requests.insert(std::to_string(i));
+        responses.insert(i * 10);
+    }
+    for(int i= 0; i < count; ++i) {
+        if(std::find(request_tickets.begin(), request_tickets.end(), i) ==
+           request_tickets.end())
+            requests.erase(i);
+        if(std::find(response_tickets.begin(), response_tickets.end(), i) ==
+           response_tickets.end())
+            responses.erase(i);
+    }
+}
+
+void test_inner_join_of_empty_maps_is_empty() {
+    request_map requests;
+    response_map responses;
+
+    auto join= jss::inner_join(requests, responses);
+    assert(join.begin() == join.end());
+    auto left= jss::left_join(requests, responses);
+    assert(left.begin() == left.end());
+}
+
+void test_inner_join_yields_common_tickets() {
+    request_map requests;
+    response_map responses;
+    fill(
+        requests, responses, {1, 2, 3, 5, 8, 13, 21, 34, 55, 89, 144},
+        {0, 2, 4, 8, 16, 32, 64, 89, 128, 144, 199}, 200);
+
+    std::vector<int> tickets;
+    for(auto e : jss::inner_join(requests, responses)) {
+        static_assert(std::is_same_v<decltype(e.lhs), std::string &>);
+        static_assert(std::is_same_v<decltype(e.rhs), int &>);
+        assert(e.lhs == std::to_string(e.ticket));
+        assert(e.rhs == e.ticket * 10);
+        tickets.push_back(e.ticket);
+    }
+    std::vector<int> const expected= {2, 8, 89, 144};
+    assert(tickets == expected);
+}
+
+void test_left_join_yields_all_left_tickets() {
+    request_map requests;
+    response_map responses;
+    fill(
+        requests, responses, {1, 2, 3, 5, 8, 13, 21, 34, 55, 89, 144},
+        {0, 2, 4, 8, 16, 32, 64, 89, 128, 144, 199}, 200);
+
+    std::vector<int> tickets;
+    std::vector<int> matched;
+    for(auto e : jss::left_join(requests, responses)) {
+        static_assert(std::is_same_v<decltype(e.rhs), int *>);
+        assert(e.lhs == std::to_string(e.ticket));
+        tickets.push_back(e.ticket);
+        if(e.rhs) {
+            assert(*e.rhs == e.ticket * 10);
+            matched.push_back(e.ticket);
+        }
+    }
+    std::vector<int> const expected= {1, 2, 3, 5, 8, 13, 21, 34, 55, 89, 144};
+    assert(tickets == expected);
+    std::vector<int> const expected_matches= {2, 8, 89, 144};
+    assert(matched == expected_matches);
+}
+
+void test_join_can_modify_non_const_maps() {
+    request_map requests;
+    response_map responses;
+    fill(requests, responses, {1, 2, 3}, {2, 3, 4}, 5);
+
+    for(auto e : jss::inner_join(requests, responses)) {
+        e.lhs+= "!";
+        ++e.rhs;
+    }
+    assert(requests[2] == "2!");
+    assert(responses[3] == 31);
+
+    auto const &crequests= requests;
+    for(auto e : jss::inner_join(crequests, responses)) {
+        static_assert(std::is_same_v<decltype(e.lhs), std::string const &>);
+    }
+}
+
+void test_join_of_disjoint_ranges() {
+    request_map requests;
+    response_map responses;
+    for(int i= 0; i < 1000; ++i) {
+        requests.insert(std::to_string(i));
+    }
+    responses.insert_with_ticket(999, 42);
+    responses.insert_with_ticket(5000, 43);
+
+    std::vector<int> tickets;
+    for(auto e : jss::inner_join(requests, responses)) {
+        tickets.push_back(e.ticket);
+    }
+    assert(tickets == std::vector<int>{999});
+
+    tickets.clear();
+    for(auto e : jss::inner_join(responses, requests)) {
+        tickets.push_back(e.ticket);
+    }
+    assert(tickets == std::vector<int>{999});
+
+    std::size_t count= 0;
+    for(auto e : jss::left_join(responses, requests)) {
+        assert((e.rhs != nullptr) == (e.ticket == 999));
+        ++count;
+    }
+    assert(count == 2);
+}
+
+int main() {
+    test_inner_join_of_empty_maps_is_empty();
+    test_inner_join_yields_common_tickets();
+    test_left_join_yields_all_left_tickets();
+    test_join_can_modify_non_const_maps();
+    test_join_of_disjoint_ranges();
+}
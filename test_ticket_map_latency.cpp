@@ -0,0 +1,94 @@
+#include "ticket_map_latency.hpp"
+#include <assert.h>
+#include <sstream>
+#include <string>
+
+void test_latency_policy_times_every_operation() {
+    jss::operation_latencies latencies;
+    jss::ticket_map<unsigned, int, jss::latency_policy<>> map(
+        jss::latency_policy<>{latencies});
+
+    for(unsigned i= 0; i < 1000; ++i) {
+        map.insert(i);
+    }
+    for(unsigned i= 0; i < 1000; ++i) {
+        assert(map[i] == i);
+    }
+    for(unsigned i= 0; i < 600; ++i) {
+        map.erase(i);
+    }
+
+    using op= jss::ticket_map_operation;
+    assert(latencies.count(op::insert) == 1000);
+    assert(latencies.count(op::find) == 1000);
+    assert(latencies.count(op::erase) == 600);
+    assert(latencies.count(op::compact) >= 1);
+    assert(latencies.count(op::reserve) >= 1);
+    assert(latencies.percentile(op::insert, 50) <=
+           latencies.percentile(op::insert, 99));
+    assert(latencies.percentile(op::insert, 99) <= latencies.max(op::insert));
+}
+
+void test_latency_policy_samples() {
+    jss::operation_latencies latencies(10);
+    jss::ticket_map<unsigned, int, jss::latency_policy<>> map(
+        jss::latency_policy<>{latencies});
+    map.reserve(1000);
+    latencies.clear();
+
+    for(unsigned i= 0; i < 1000; ++i) {
+        map.insert(i);
+    }
+    for(unsigned i= 0; i < 1000; ++i) {
+        assert(map.count(i));
+    }
+    assert(latencies.sample_interval() == 10);
+    assert(
+        latencies.count(jss::ticket_map_operation::insert) +
+            latencies.count(jss::ticket_map_operation::find) ==
+        200);
+}
+
+void test_default_latency_policy_records_nothing() {
+    jss::ticket_map<unsigned, int, jss::latency_policy<>> map;
+    map.insert(1);
+    assert(map.find(0) != map.end());
+    map.erase(0);
+    assert(map.empty());
+}
+
+void test_latency_policies_can_be_stacked() {
+    jss::operation_latencies inner;
+    jss::operation_latencies outer;
+    using policy= jss::latency_policy<jss::latency_policy<>>;
+    jss::ticket_map<unsigned, int, policy> map(
+        policy{outer, jss::latency_policy<>{inner}});
+
+    for(unsigned i= 0; i < 100; ++i) {
+        map.insert(i);
+    }
+    assert(inner.count(jss::ticket_map_operation::insert) == 100);
+    assert(outer.count(jss::ticket_map_operation::insert) == 100);
+}
+
+void test_report_lists_every_operation() {
+    jss::operation_latencies latencies;
+    jss::ticket_map<unsigned, int, jss::latency_policy<>> map(
+        jss::latency_policy<>{latencies});
+    map.insert(42);
+
+    std::ostringstream out;
+    latencies.report(out);
+    auto const report= out.str();
+    for(auto name : {"insert", "erase", "find", "compact", "reserve"}) {
+        assert(report.find(name) != std::string::npos);
+    }
+}
+
+int main() {
+    test_latency_policy_times_every_operation();
+    test_latency_policy_samples();
+    test_default_latency_policy_records_nothing();
+    test_latency_policies_can_be_stacked();
+    test_report_lists_every_operation();
+}
@@ -0,0 +1,101 @@
+#include "ticket_map_parallel.hpp"
+#include <assert.h>
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+void test_clone_copies_in_parallel() {
+    jss::ticket_map<unsigned, std::string> map;
+    for(unsigned i= 0; i < 20000; ++i) {
+        map.insert(std::to_string(i));
+    }
+    for(unsigned i= 0; i < 20000; i+= 3) {
+        map.erase(i);
+    }
+    auto const reserved= map.reserve_ticket();
+
+    std::vector<std::thread> threads;
+    auto clone= jss::parallel_clone(
+        map, [&](auto task) { threads.emplace_back(std::move(task)); }, 4);
+    for(auto &thread : threads) {
+        thread.join();
+    }
+    assert(threads.size() == 3);
+
+    assert(clone.size() == map.size());
+    assert(clone.reserved_count() == 1);
+    for(unsigned i= 0; i < 20000; ++i) {
+        assert(clone.count(i) == map.count(i));
+        if(i % 3)
+            assert(clone[i] == std::to_string(i));
+    }
+    clone.fulfil(reserved, "reserved");
+    assert(clone[reserved] == "reserved");
+    assert(!map.count(reserved));
+    assert(clone.insert("next") == map.insert("next"));
+}
+
+void test_clone_runs_chunks_inline_if_executor_throws() {
+    jss::ticket_map<int, int> map;
+    for(int i= 0; i < 10000; ++i) {
+        map.insert(i);
+    }
+
+    unsigned submitted= 0;
+    auto clone= jss::parallel_clone(
+        map,
+        [&](auto) {
+            ++submitted;
+            throw std::runtime_error("No threads available");
+        },
+        8);
+    assert(submitted == 2);
+    assert(clone.size() == 10000);
+    assert(clone[9999] == 9999);
+}
+
+void test_teardown_destroys_elements_in_parallel() {
+    struct counted {
+        std::atomic<unsigned> *count;
+        explicit counted(std::atomic<unsigned> &count_) : count(&count_) {}
+        counted(counted &&other) noexcept :
+            count(std::exchange(other.count, nullptr)) {}
+        counted &operator=(counted &&other) noexcept {
+            std::swap(count, other.count);
+            return *this;
+        }
+        ~counted() {
+            if(count)
+                ++*count;
+        }
+    };
+    std::atomic<unsigned> destroyed{0};
+    jss::ticket_map<unsigned, counted> map;
+    for(unsigned i= 0; i < 50000; ++i) {
+        map.emplace(destroyed);
+    }
+    map.erase(0);
+    auto const last_ticket= map.reserve_ticket();
+
+    std::vector<std::thread> threads;
+    jss::parallel_teardown(
+        map, [&](auto task) { threads.emplace_back(std::move(task)); });
+    for(auto &thread : threads) {
+        thread.join();
+    }
+
+    assert(destroyed == 50000);
+    assert(map.empty());
+    assert(map.capacity() == 0);
+    assert(map.reserved_count() == 0);
+    assert(map.emplace(destroyed) == last_ticket + 1);
+}
+
+int main() {
+    test_clone_copies_in_parallel();
+    test_clone_runs_chunks_inline_if_executor_throws();
+    test_teardown_destroys_elements_in_parallel();
+}
@@ -0,0 +1,79 @@
+#include "ticket_map.hpp"
+#include <assert.h>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+/// Return true if the executable contains a probe note for name
+bool has_probe(std::string const &executable, char const *name) {
+    std::string const note= std::string("jss_ticket_map") + '\0' + name + '\0';
+    return executable.find(note) != std::string::npos;
+}
+
+void test_probes_do_not_change_behaviour() {
+    jss::ticket_map<unsigned char, int> map;
+    for(unsigned i= 0; i < 100; ++i) {
+        map.insert(i);
+    }
+    for(unsigned i= 0; i < 60; ++i) {
+        map.erase(i);
+    }
+    assert(map.size() == 40);
+    assert(map.tickets().size() < 100);
+
+    {
+        auto batch= map.batch();
+        for(unsigned i= 0; i < 50; ++i) {
+            batch.insert(i);
+        }
+    }
+    assert(map.size() == 90);
+
+    auto loader= map.bulk_load({10, 20});
+    loader.commit();
+    assert(map.size() == 90);
+
+    map.reserve(1000);
+    assert(map.capacity() >= 1000);
+    assert(map[99] == 99);
+
+    auto loaded= map.bulk_load({});
+    loaded.commit();
+    try {
+        map.bulk_load({100});
+        assert(!"Should not be able to load past the last ticket");
+    } catch(std::overflow_error &) {
+        assert(true);
+    }
+    for(unsigned i= 180; i < 256; ++i) {
+        map.insert(0);
+    }
+    try {
+        map.insert(0);
+        assert(!"Should not be able to insert once tickets overflow");
+    } catch(std::overflow_error &) {
+        assert(true);
+    }
+}
+
+void test_probes_are_in_the_executable() {
+#if JSS_HAS_USDT_PROBES && defined(__linux__)
+    std::ifstream file("/proc/self/exe", std::ios::binary);
+    std::string const executable(
+        (std::istreambuf_iterator<char>(file)),
+        std::istreambuf_iterator<char>());
+    assert(!executable.empty());
+    for(auto name :
+        {"compact_start", "compact_end", "reallocate_start", "reallocate_end",
+         "batch_start", "batch_end", "bulk_load_start", "bulk_load_end",
+         "overflow"}) {
+        assert(has_probe(executable, name));
+    }
+#endif
+}
+
+int main() {
+    test_probes_do_not_change_behaviour();
+    test_probes_are_in_the_executable();
+}
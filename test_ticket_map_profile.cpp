@@ -0,0 +1,110 @@
+#include "ticket_map_profile.hpp"
+#include <assert.h>
+#include <array>
+#include <numeric>
+#include <sstream>
+#include <string>
+
+void test_age_in_tickets_is_measured_at_erase() {
+    jss::lifetime_profile profile;
+    jss::ticket_map<unsigned, int, jss::profiling_policy<>> map(
+        jss::profiling_policy<>{profile});
+
+    for(unsigned i= 0; i < 100; ++i) {
+        map.insert(i);
+    }
+    map.erase(10);
+    map.erase(99);
+
+    assert(profile.age_in_tickets().count() == 2);
+    assert(profile.age_in_tickets().max() == 89);
+    assert(profile.age_in_nanoseconds().count() == 2);
+}
+
+void test_compaction_moves_of_stragglers_are_counted() {
+    jss::lifetime_profile profile(100);
+    jss::ticket_map<unsigned, int, jss::profiling_policy<>> map(
+        jss::profiling_policy<>{profile});
+
+    for(unsigned i= 0; i < 1000; ++i) {
+        map.insert(i);
+        if(i >= 10 && (i - 10) % 50)
+            map.erase(i - 10);
+    }
+    assert(map.count(500));
+    assert(profile.compaction_moves() > profile.straggler_moves());
+    assert(profile.straggler_moves() > 0);
+    assert(profile.straggler_fraction() > 0);
+    assert(profile.straggler_fraction() < 1);
+}
+
+void test_default_profiling_policy_records_nothing() {
+    jss::ticket_map<unsigned, int, jss::profiling_policy<>> map;
+    for(unsigned i= 0; i < 100; ++i) {
+        map.insert(i);
+    }
+    for(unsigned i= 0; i < 100; ++i) {
+        map.erase(i);
+    }
+    assert(map.empty());
+}
+
+void test_fragmentation_counts_holes_per_page() {
+    jss::ticket_map<
+        unsigned, std::array<char, 1000>, jss::deferred_compaction_policy<>>
+        map;
+    for(unsigned i= 0; i < 40; ++i) {
+        map.insert(std::array<char, 1000>());
+    }
+    for(unsigned i= 0; i < 20; i+= 2) {
+        map.erase(i);
+    }
+
+    auto const profile= jss::profile_fragmentation(map);
+    assert(profile.slots == 40);
+    assert(profile.holes == 10);
+    assert(profile.slots_per_page.size() >= 10);
+    assert(
+        std::accumulate(
+            profile.slots_per_page.begin(), profile.slots_per_page.end(),
+            std::size_t()) == 40);
+    assert(
+        std::accumulate(
+            profile.holes_per_page.begin(), profile.holes_per_page.end(),
+            std::size_t()) == 10);
+
+    auto const pages= profile.pages_by_hole_fraction();
+    assert(
+        std::accumulate(pages.begin(), pages.end(), std::size_t()) ==
+        profile.slots_per_page.size());
+    auto const by_position= profile.hole_fraction_by_position(2);
+    assert(by_position.size() == 2);
+    assert(by_position[0] > 0.4);
+    assert(by_position[1] == 0);
+}
+
+void test_reports_are_written() {
+    jss::lifetime_profile lifetimes;
+    jss::ticket_map<unsigned, int, jss::profiling_policy<>> map(
+        jss::profiling_policy<>{lifetimes});
+    for(unsigned i= 0; i < 100; ++i) {
+        map.insert(i);
+    }
+    map.erase(5);
+
+    std::ostringstream out;
+    lifetimes.report(out);
+    jss::profile_fragmentation(map).report(out);
+    auto const report= out.str();
+    assert(report.find("tickets") != std::string::npos);
+    assert(report.find("compaction moves") != std::string::npos);
+    assert(report.find("100 slots") != std::string::npos);
+}
+
+int main() {
+    test_age_in_tickets_is_measured_at_erase();
+    test_compaction_moves_of_stragglers_are_counted();
+    test_default_profiling_policy_records_nothing();
+    test_fragmentation_counts_holes_per_page();
+    test_reports_are_written();
+}
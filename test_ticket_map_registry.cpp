@@ -0,0 +1,175 @@
+#include "ticket_map_registry.hpp"
+#include <assert.h>
+#include <atomic>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+    /// Return the snapshot entry for the map registered under name
+    jss::ticket_map_registry::entry
+    find_entry(jss::ticket_map_registry const &registry, char const *name) {
+        for(auto const &entry : registry.snapshot()) {
+            if(!std::strcmp(entry.name, name))
+                return entry;
+        }
+        assert(!"No map registered under that name");
+        return {};
+    }
+} // namespace
+
+void test_maps_register_and_report_their_storage() {
+    jss::ticket_map_registry registry;
+    using policy= jss::registry_policy<>;
+    {
+        jss::ticket_map<unsigned, int, policy> first(
+            policy("first", registry));
+        jss::ticket_map<unsigned, double, policy> second(
+            policy("second", registry));
+        assert(registry.snapshot().size() == 2);
+
+        for(unsigned i= 0; i < 100; ++i) {
+            first.insert(i);
+        }
+        for(unsigned i= 0; i < 20; ++i) {
+            first.erase(i);
+        }
+        first.shrink_to_fit();
+        first.reserve(200);
+
+        auto const entry= find_entry(registry, "first");
+        assert(entry.size == 80);
+        assert(entry.slots == 80);
+        assert(entry.capacity == first.capacity());
+        assert(entry.bytes == first.memory_usage());
+        assert(entry.bytes >= 200 * sizeof(unsigned));
+        assert(entry.hole_ratio() == 0);
+        assert(std::string(entry.type).find("ticket_map") !=
+               std::string::npos);
+        assert(find_entry(registry, "second").size == 0);
+    }
+    assert(registry.snapshot().empty());
+}
+
+void test_copies_register_separately_and_moves_take_over() {
+    jss::ticket_map_registry registry;
+    using policy= jss::registry_policy<>;
+    jss::ticket_map<unsigned, int, policy> map(policy("map", registry));
+    for(unsigned i= 0; i < 10; ++i) {
+        map.insert(i);
+    }
+
+    auto copy= map;
+    assert(registry.snapshot().size() == 2);
+    assert(find_entry(registry, "map").size == 10);
+
+    auto moved= std::move(copy);
+    assert(registry.snapshot().size() == 2);
+    assert(moved.get_policy().registered_name() == std::string("map"));
+    assert(copy.get_policy().registered_name() == std::string(""));
+
+    moved= std::move(map);
+    assert(registry.snapshot().size() == 1);
+}
+
+void test_copy_assignment_keeps_registration() {
+    jss::ticket_map_registry registry;
+    using policy= jss::registry_policy<>;
+    jss::ticket_map<unsigned, int, policy> first(policy("first", registry));
+    jss::ticket_map<unsigned, int, policy> second(policy("second", registry));
+    for(unsigned i= 0; i < 10; ++i) {
+        second.insert(i);
+    }
+
+    first= second;
+    assert(registry.snapshot().size() == 2);
+    assert(first.get_policy().registered_name() == std::string("first"));
+    assert(find_entry(registry, "first").size == 10);
+    assert(first.size() == 10);
+    assert(first.insert(10) == 10);
+}
+
+void test_entries_of_destroyed_maps_are_reused() {
+    jss::ticket_map_registry registry;
+    using policy= jss::registry_policy<>;
+    for(unsigned i= 0; i < 10; ++i) {
+        jss::ticket_map<unsigned, int, policy> map(policy("temp", registry));
+        map.insert(i);
+        assert(registry.snapshot().size() == 1);
+    }
+    assert(registry.snapshot().empty());
+}
+
+void test_snapshot_while_maps_come_and_go() {
+    jss::ticket_map_registry registry;
+    using policy= jss::registry_policy<>;
+    std::atomic<bool> done{false};
+    std::vector<std::thread> threads;
+    for(unsigned t= 0; t < 4; ++t) {
+        threads.emplace_back([&] {
+            for(unsigned i= 0; i < 200; ++i) {
+                jss::ticket_map<unsigned, int, policy> map(
+                    policy("worker", registry));
+                for(unsigned j= 0; j < 100; ++j) {
+                    map.insert(j);
+                }
+            }
+        });
+    }
+    std::thread reader([&] {
+        while(!done) {
+            for(auto const &entry : registry.snapshot()) {
+                assert(entry.size <= 100);
+            }
+        }
+    });
+    for(auto &thread : threads) {
+        thread.join();
+    }
+    done= true;
+    reader.join();
+    assert(registry.snapshot().empty());
+}
+
+void test_report_lists_maps_largest_first() {
+    jss::ticket_map_registry registry;
+    using policy= jss::registry_policy<>;
+    jss::ticket_map<unsigned, int, policy> small(policy("small", registry));
+    jss::ticket_map<unsigned, int, policy> large(policy("large", registry));
+    small.reserve(10);
+    large.reserve(1000);
+
+    std::ostringstream out;
+    registry.report(out);
+    auto const report= out.str();
+    auto const large_pos= report.find("large");
+    auto const small_pos= report.find("small");
+    assert(large_pos != std::string::npos);
+    assert(small_pos != std::string::npos);
+    assert(large_pos < small_pos);
+    assert(report.find("total") > small_pos);
+}
+
+void test_default_policy_uses_global_registry() {
+    auto const before= jss::ticket_map_registry::global().snapshot().size();
+    {
+        jss::ticket_map<unsigned, int, jss::registry_policy<>> map;
+        assert(
+            jss::ticket_map_registry::global().snapshot().size() ==
+            before + 1);
+    }
+    assert(jss::ticket_map_registry::global().snapshot().size() == before);
+}
+
+int main() {
+    test_maps_register_and_report_their_storage();
+    test_copies_register_separately_and_moves_take_over();
+    test_copy_assignment_keeps_registration();
+    test_entries_of_destroyed_maps_are_reused();
+    test_snapshot_while_maps_come_and_go();
+    test_report_lists_maps_largest_first();
+    test_default_policy_uses_global_registry();
+}
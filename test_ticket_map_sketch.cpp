@@ -0,0 +1,108 @@
+#include "ticket_map_sketch.hpp"
+#include <assert.h>
+#include <thread>
+#include <vector>
+
+void test_sketch_finds_the_hottest_tickets() {
+    jss::access_sketch sketch(64, 1);
+    for(unsigned round= 1; round <= 1000; ++round) {
+        for(unsigned ticket= 1; ticket <= 200; ++ticket) {
+            if(round % ticket == 0)
+                sketch.record(ticket);
+        }
+    }
+
+    auto const hottest= sketch.top(5);
+    assert(hottest.size() == 5);
+    for(unsigned i= 0; i < 5; ++i) {
+        assert(hottest[i].ticket == i + 1);
+    }
+    assert(hottest[0].count == 1000);
+    assert(hottest[0].error == 0);
+    assert(sketch.skew() > 0.5);
+    assert(sketch.top_share(5) > 0.3);
+}
+
+void test_uniform_lookups_have_little_skew() {
+    jss::access_sketch sketch(16, 1);
+    for(unsigned round= 0; round < 100; ++round) {
+        for(unsigned ticket= 0; ticket < 1000; ++ticket) {
+            sketch.record(ticket);
+        }
+    }
+    assert(sketch.samples() == 100000);
+    assert(sketch.skew() < 0.2);
+    assert(sketch.top_share(5) < 0.05);
+}
+
+void test_sketch_samples_lookups() {
+    jss::access_sketch sketch(8, 10);
+    for(unsigned i= 0; i < 1000; ++i) {
+        sketch.record(i % 3);
+    }
+    assert(sketch.sample_interval() == 10);
+    assert(sketch.samples() == 100);
+
+    sketch.clear();
+    assert(sketch.samples() == 0);
+    assert(sketch.top(3).empty());
+}
+
+void test_policy_records_lookups() {
+    jss::access_sketch sketch(8, 1);
+    jss::ticket_map<unsigned, int, jss::access_sketch_policy<>> map(
+        jss::access_sketch_policy<>{sketch});
+    for(unsigned i= 0; i < 10; ++i) {
+        map.insert(i);
+    }
+    assert(sketch.samples() == 0);
+
+    for(unsigned i= 0; i < 50; ++i) {
+        assert(map.find(3) != map.end());
+        assert(map[4] == 4);
+    }
+    assert(map.count(7));
+    assert(map.find(42) == map.end());
+    map.erase(3);
+
+    auto const hottest= sketch.top(2);
+    assert(sketch.samples() == 102);
+    assert(hottest[0].count == 50);
+    assert(hottest[1].count == 50);
+}
+
+void test_concurrent_lookups_on_const_map() {
+    jss::access_sketch sketch(8, 4);
+    jss::ticket_map<unsigned, int, jss::access_sketch_policy<>> map(
+        jss::access_sketch_policy<>{sketch});
+    for(unsigned i= 0; i < 100; ++i) {
+        map.insert(i);
+    }
+    auto const &const_map= map;
+
+    std::vector<std::thread> threads;
+    for(unsigned t= 0; t < 4; ++t) {
+        threads.emplace_back([&, t] {
+            for(unsigned i= 0; i < 10000; ++i) {
+                assert(const_map.find((i * (t + 1)) % 10) != const_map.end());
+            }
+        });
+    }
+    for(unsigned i= 0; i < 100; ++i) {
+        assert(sketch.top(3).size() <= 3);
+    }
+    for(auto &thread : threads) {
+        thread.join();
+    }
+    assert(sketch.samples() > 0);
+    assert(sketch.top(20).size() <= 8);
+    assert(sketch.top(1)[0].ticket < 10);
+}
+
+int main() {
+    test_sketch_finds_the_hottest_tickets();
+    test_uniform_lookups_have_little_skew();
+    test_sketch_samples_lookups();
+    test_policy_records_lookups();
+    test_concurrent_lookups_on_const_map();
+}
@@ -0,0 +1,170 @@
+#include "ticket_map_trace.hpp"
+#include "columnar_ticket_map.hpp"
+#include <assert.h>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+void test_latency_histogram_percentiles() {
+    jss::latency_histogram histogram;
+    assert(histogram.count() == 0);
+    assert(histogram.percentile(50) == 0);
+
+    for(std::uint64_t i= 1; i <= 1000; ++i) {
+        histogram.record(i);
+    }
+    assert(histogram.count() == 1000);
+    assert(histogram.max() == 1000);
+    assert(histogram.mean() == 500.5);
+    assert(histogram.percentile(0) == 1);
+    assert(histogram.percentile(100) == 1000);
+    auto const median= histogram.percentile(50);
+    assert(median >= 500 && median <= 500 * 1.04);
+    auto const p99= histogram.percentile(99);
+    assert(p99 >= 990 && p99 <= 990 * 1.04);
+
+    histogram.record(std::uint64_t(1) << 62);
+    assert(histogram.percentile(100) == std::uint64_t(1) << 62);
+
+    jss::latency_histogram other;
+    other.record(7);
+    histogram.merge(other);
+    assert(histogram.count() == 1002);
+    histogram.clear();
+    assert(histogram.count() == 0);
+}
+
+void test_recording_policy_records_operations() {
+    std::stringstream trace;
+    {
+        jss::trace_writer writer(trace);
+        jss::ticket_map<int, std::string, jss::recording_policy<>> map(
+            jss::recording_policy<>{writer});
+
+        auto first= map.insert("first");
+        auto second= map.insert("second");
+        assert(map[first] == "first");
+        assert(map.find(42) == map.end());
+        map.erase(first);
+        {
+            auto batch= map.batch();
+            batch.insert("third");
+            batch.erase(second);
+        }
+        assert(map.count(2));
+    }
+
+    jss::trace_reader reader(trace);
+    std::vector<jss::trace_record> records;
+    jss::trace_record record;
+    while(reader.next(record)) {
+        records.push_back(record);
+    }
+
+    using op= jss::ticket_map_operation;
+    std::vector<std::pair<op, std::uint64_t>> const expected{
+        {op::insert, 0}, {op::insert, 1}, {op::find, 0}, {op::find, 42},
+        {op::erase, 0},  {op::erase, 1},  {op::insert, 2}, {op::find, 2}};
+    assert(records.size() == expected.size());
+    for(std::size_t i= 0; i < records.size(); ++i) {
+        assert(records[i].op == expected[i].first);
+        assert(records[i].ticket == expected[i].second);
+        if(i)
+            assert(records[i].timestamp >= records[i - 1].timestamp);
+    }
+}
+
+void test_default_recording_policy_records_nothing() {
+    jss::ticket_map<int, int, jss::recording_policy<>> map;
+    map.erase(map.insert(1));
+    assert(map.empty());
+}
+
+void test_replay_reproduces_map() {
+    std::stringstream trace;
+    jss::ticket_map<unsigned, int, jss::recording_policy<>> original;
+    {
+        jss::trace_writer writer(trace);
+        original.get_policy().writer= &writer;
+        for(unsigned i= 0; i < 10000; ++i) {
+            original.insert(i);
+            if(i % 3 == 0)
+                original.erase(i / 2);
+            original.find(i / 4);
+        }
+        original.get_policy().writer= nullptr;
+    }
+
+    jss::ticket_map<unsigned, int, jss::release_memory_policy<>> replayed;
+    auto statistics= jss::replay_trace(trace, replayed);
+
+    assert(statistics.operations() == 10000 * 2 + 3334);
+    assert(statistics[jss::ticket_map_operation::insert].count() == 10000);
+    assert(statistics[jss::ticket_map_operation::erase].count() == 3334);
+    assert(statistics[jss::ticket_map_operation::find].count() == 10000);
+    assert(statistics.elapsed > 0);
+    assert(replayed.size() == original.size());
+    for(auto const &entry : original) {
+        assert(replayed.count(entry.ticket));
+    }
+}
+
+void test_synthetic_workload_replays_against_columnar_map() {
+    jss::workload_spec spec;
+    spec.live= 100;
+    spec.operations= 1000;
+    spec.lookups= 2;
+    std::stringstream trace;
+    jss::record_workload(trace, spec);
+
+    jss::columnar_ticket_map<unsigned, std::tuple<int, double>> map;
+    auto statistics= jss::replay_trace(trace, map);
+
+    auto const inserts=
+        statistics[jss::ticket_map_operation::insert].count();
+    auto const erases= statistics[jss::ticket_map_operation::erase].count();
+    assert(inserts + erases == 1000);
+    assert(inserts > 100);
+    assert(statistics[jss::ticket_map_operation::find].count() == 2000);
+    assert(statistics.found == 2000);
+    assert(map.size() == inserts - erases);
+    assert(statistics.peak_capacity >= map.size());
+    assert(statistics.peak_capacity >= map.capacity());
+}
+
+void test_reader_rejects_bad_traces() {
+    std::stringstream not_trace("definitely not a trace");
+    try {
+        jss::trace_reader reader(not_trace);
+        assert(!"Should reject a stream without the header");
+    } catch(std::runtime_error &) {
+        assert(true);
+    }
+
+    std::stringstream trace;
+    {
+        jss::trace_writer writer(trace);
+        writer.record(jss::ticket_map_operation::insert, 1000000);
+    }
+    auto truncated= trace.str();
+    truncated.pop_back();
+    std::stringstream truncated_trace(truncated);
+    jss::trace_reader reader(truncated_trace);
+    jss::trace_record record;
+    try {
+        reader.next(record);
+        assert(!"Should reject a truncated trace");
+    } catch(std::runtime_error &) {
+        assert(true);
+    }
+}
+
+int main() {
+    test_latency_histogram_percentiles();
+    test_recording_policy_records_operations();
+    test_default_recording_policy_records_nothing();
+    test_replay_reproduces_map();
+    test_synthetic_workload_replays_against_columnar_map();
+    test_reader_rejects_bad_traces();
+}
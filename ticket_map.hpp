@@ -4,15 +4,247 @@
 
 #pragma once
 
+#include "ticket_map_probes.hpp"
 #include <cstdlib>
 #include <vector>
 #include <algorithm>
 #include <type_traits>
 #include <optional>
 #include <stdexcept>
+#include <limits>
+#include <new>
+#include <utility>
+#include <iterator>
+#include <tuple>
 
 namespace jss {
 
+    namespace detail {
+        /// Increment a ticket and check for overflow (generic)
+        template <typename T>
+        std::enable_if_t<!std::is_integral_v<T>, T>
+        increment_with_overflow_check(T &value, bool &overflow) {
+            auto id= value++;
+            if(value < id || value == id)
+                overflow= true;
+            return id;
+        }
+
+        /// Increment a ticket and check for overflow (integral)
+        template <typename T>
+        std::enable_if_t<std::is_integral_v<T>, T>
+        increment_with_overflow_check(T &value, bool &overflow) {
+            auto id= value;
+            if(value == std::numeric_limits<T>::max())
+                overflow= true;
+            else
+                ++value;
+            return id;
+        }
+
+        /// Advance a ticket past count values, as if by calling
+        /// increment_with_overflow_check count times (generic). Throws
+        /// overflow_error if there are fewer than count values left, in which
+        /// case value and overflow are unchanged.
+        template <typename T>
+        std::enable_if_t<!std::is_integral_v<T>>
+        advance_with_overflow_check(
+            T &value, std::size_t count, bool &overflow) {
+            auto next= value;
+            auto nextOverflow= overflow;
+            for(; count; --count) {
+                if(nextOverflow)
+                    throw std::overflow_error(
+                        "Ticket values overflowed; cannot insert");
+                increment_with_overflow_check(next, nextOverflow);
+            }
+            value= next;
+            overflow= nextOverflow;
+        }
+
+        /// Advance a ticket past count values, as if by calling
+        /// increment_with_overflow_check count times (integral). Throws
+        /// overflow_error if there are fewer than count values left, in which
+        /// case value and overflow are unchanged.
+        template <typename T>
+        std::enable_if_t<std::is_integral_v<T>> advance_with_overflow_check(
+            T &value, std::size_t count, bool &overflow) {
+            using unsigned_type= std::make_unsigned_t<T>;
+            if(!count)
+                return;
+            auto const remaining= unsigned_type(
+                unsigned_type(std::numeric_limits<T>::max()) -
+                unsigned_type(value));
+            if(overflow || remaining < count - 1)
+                throw std::overflow_error(
+                    "Ticket values overflowed; cannot insert");
+            if(remaining == count - 1) {
+                value= std::numeric_limits<T>::max();
+                overflow= true;
+            } else {
+                value= T(unsigned_type(unsigned_type(value) + count));
+            }
+        }
+
+        /// Gives the parallel operations in ticket_map_parallel.hpp access to
+        /// the storage of a ticket_map
+        struct ticket_map_parallel_access;
+
+        /// Gives background_compacting_ticket_map access to the storage of a
+        /// ticket_map
+        struct ticket_map_background_access;
+    } // namespace detail
+
+    /// The operations on a ticket_map reported to the policy's on_operation
+    /// and start_timer hooks. Only insert, erase and find are reported to
+    /// on_operation.
+    enum class ticket_map_operation {
+        /// An element was inserted
+        insert,
+        /// An element was erased
+        erase,
+        /// An element was looked up
+        find,
+        /// The storage was compacted in place
+        compact,
+        /// The storage was reserved, or grown to make room for an insert
+        reserve
+    };
+
+    namespace detail {
+        /// The timer returned by the default policy, which times nothing
+        struct null_operation_timer {};
+    } // namespace detail
+
+    /// The default policy for a ticket_map. A policy controls how a
+    /// ticket_map manages its storage. Custom policies should derive from
+    /// this class, either directly or via another policy, and hide the
+    /// members whose behaviour they wish to change.
+    struct default_ticket_map_policy {
+        /// Return the capacity the storage should be reduced to after elements
+        /// have been removed, given the number of live elements and the
+        /// current capacity. Returning capacity leaves the storage alone.
+        constexpr std::size_t shrink_capacity(
+            std::size_t /*size*/, std::size_t capacity) const noexcept {
+            return capacity;
+        }
+
+        /// Return true if the storage should be compacted to remove empty
+        /// slots, given the number of occupied slots and the total number of
+        /// slots. By default, the storage is compacted once fewer than half
+        /// the slots are occupied.
+        constexpr bool needs_compaction(
+            std::size_t occupied, std::size_t slots) const noexcept {
+            return occupied < slots / 2;
+        }
+
+        /// Return the capacity to grow the storage to when it is full, given
+        /// the number of live elements and the current capacity. By default,
+        /// the capacity is twice the number of live elements.
+        constexpr std::size_t grow_capacity(
+            std::size_t size, std::size_t /*capacity*/) const noexcept {
+            return size * 2;
+        }
+
+        /// Start timing an operation on the map. The returned object is
+        /// destroyed when the operation is complete. By default, nothing is
+        /// timed.
+        constexpr detail::null_operation_timer
+        start_timer(ticket_map_operation) const noexcept {
+            return {};
+        }
+
+        /// Called whenever a single element is inserted, erased or looked up,
+        /// with its ticket. Lookups are reported whether or not they find an
+        /// element; bulk operations such as clear() and assign_sorted() are
+        /// not reported. Does nothing by default.
+        template <typename Ticket>
+        constexpr void
+        on_operation(ticket_map_operation, Ticket const &) const noexcept {}
+
+        /// Called with the ticket of each element moved by compaction or
+        /// reallocation, before it is moved. Does nothing by default.
+        template <typename Ticket>
+        constexpr void on_compaction_move(Ticket const &) const noexcept {}
+
+        /// Called with the map after its storage has been reallocated,
+        /// compacted, cleared or replaced, or the map has been copied, so the
+        /// policy can inspect it. Inserts, erasures and lookups that don't
+        /// change the storage don't call it. Does nothing by default.
+        template <typename Map>
+        constexpr void on_storage_changed(Map const &) const noexcept {}
+    };
+
+    /// A policy that releases memory when the capacity exceeds Factor times
+    /// the number of live elements. The storage is then reduced to twice the
+    /// number of live elements, so subsequent inserts don't immediately grow
+    /// it again. Storage with a capacity of MinCapacity or less is never
+    /// released, and nor is the storage of a map whose values might throw
+    /// when moved.
+    template <
+        std::size_t Factor= 4, std::size_t MinCapacity= 16,
+        typename Base= default_ticket_map_policy>
+    struct release_memory_policy : Base {
+        static_assert(
+            Factor > 2, "Factor must be larger than the shrink target of 2");
+
+        /// Return the capacity to shrink to
+        constexpr std::size_t
+        shrink_capacity(std::size_t size, std::size_t capacity) const noexcept {
+            if(capacity <= MinCapacity || capacity / Factor <= size)
+                return Base::shrink_capacity(size, capacity);
+            return std::max(size * 2, MinCapacity);
+        }
+    };
+
+    /// A policy that never compacts the storage as a side effect of erasing
+    /// an element, so erasing never has to move the other elements. The
+    /// storage is only compacted when it is full and inserting reallocates
+    /// it.
+    template <typename Base= default_ticket_map_policy>
+    struct deferred_compaction_policy : Base {
+        /// Never compact
+        constexpr bool
+        needs_compaction(std::size_t, std::size_t) const noexcept {
+            return false;
+        }
+    };
+
+    /// A policy that compacts the storage once fewer than
+    /// Numerator/Denominator of the slots are occupied. A lower threshold
+    /// compacts less often, at the cost of more empty slots to skip over.
+    template <
+        std::size_t Numerator, std::size_t Denominator,
+        typename Base= default_ticket_map_policy>
+    struct compaction_threshold_policy : Base {
+        static_assert(
+            Numerator > 0 && Numerator < Denominator,
+            "The threshold must be strictly between 0 and 1");
+
+        /// Compact if the occupied fraction is below the threshold
+        constexpr bool needs_compaction(
+            std::size_t occupied, std::size_t slots) const noexcept {
+            return occupied * Denominator < slots * Numerator;
+        }
+    };
+
+    /// A policy that grows full storage to Numerator/Denominator times the
+    /// number of live elements. A smaller factor uses less memory, at the cost
+    /// of growing more often.
+    template <
+        std::size_t Numerator, std::size_t Denominator,
+        typename Base= default_ticket_map_policy>
+    struct growth_factor_policy : Base {
+        static_assert(
+            Numerator > Denominator, "The growth factor must be above 1");
+
+        /// Return the capacity to grow to
+        constexpr std::size_t grow_capacity(
+            std::size_t size, std::size_t /*capacity*/) const noexcept {
+            return std::max(size * Numerator / Denominator, size + 1);
+        }
+    };
+
     /// A map between from Ticket values to Value values.
     ///
     /// Ticket must be default-constructible, incrementable, less-than
@@ -21,7 +253,13 @@ namespace jss {
     /// When new values are inserted they are assigned new Ticket values
     /// automatically. If the Ticket value overflows then no more values can be
     /// inserted.
-    template <typename Ticket, typename Value> class ticket_map {
+    ///
+    /// Policy controls the management of the storage; see
+    /// default_ticket_map_policy.
+    template <
+        typename Ticket, typename Value,
+        typename Policy= default_ticket_map_policy>
+    class ticket_map {
 
         static_assert(
             std::is_default_constructible<Ticket>(),
@@ -163,8 +401,516 @@ namespace jss {
         /// Standard const_iterator typedef
         using const_iterator= iterator_impl<true>;
 
+    private:
+        /// The type of a slot in the storage
+        using entry_type= typename collection_type::value_type;
+
+        /// Projection from a slot to its ticket
+        struct ticket_projection {
+            constexpr Ticket const &
+            operator()(entry_type const &entry) const noexcept {
+                return entry.first;
+            }
+        };
+
+        /// Projection from a slot to its value. The slot must hold a value.
+        struct value_projection {
+            constexpr Value &operator()(entry_type &entry) const noexcept {
+                return *entry.second;
+            }
+            constexpr Value const &
+            operator()(entry_type const &entry) const noexcept {
+                return *entry.second;
+            }
+        };
+
+        /// Projection from a slot to whether or not it holds a value
+        struct occupancy_projection {
+            constexpr bool operator()(entry_type const &entry) const noexcept {
+                return entry.second.has_value();
+            }
+        };
+
+    public:
+        /// A random-access view of one part of each of a contiguous sequence of
+        /// slots in the storage. Indexing the view has no branches, so simple
+        /// loops over it can be vectorized by the compiler.
+        template <typename Entry, typename Projection> class slot_view {
+        public:
+            /// The type returned by indexing the view
+            using reference= decltype(
+                std::declval<Projection>()(std::declval<Entry &>()));
+
+            /// An iterator over the view
+            class iterator {
+            public:
+                /// Required iterator typedefs
+                using iterator_category= std::input_iterator_tag;
+                /// Required iterator typedefs
+                using value_type= std::remove_cv_t<
+                    std::remove_reference_t<slot_view::reference>>;
+                /// Required iterator typedefs
+                using reference= slot_view::reference;
+                /// Required iterator typedefs
+                using pointer= void;
+                /// Required iterator typedefs
+                using difference_type= std::ptrdiff_t;
+
+                /// Dereference the iterator
+                constexpr reference operator*() const noexcept {
+                    return Projection()(*entry);
+                }
+
+                /// Pre-increment
+                constexpr iterator &operator++() noexcept {
+                    ++entry;
+                    return *this;
+                }
+
+                /// Post-increment
+                constexpr iterator operator++(int) noexcept {
+                    iterator temp{*this};
+                    ++entry;
+                    return temp;
+                }
+
+                /// Compare iterators for equality
+                friend constexpr bool
+                operator==(iterator const &lhs, iterator const &rhs) noexcept {
+                    return lhs.entry == rhs.entry;
+                }
+
+                /// Compare iterators for inequality
+                friend constexpr bool
+                operator!=(iterator const &lhs, iterator const &rhs) noexcept {
+                    return lhs.entry != rhs.entry;
+                }
+
+            private:
+                friend class slot_view;
+
+                constexpr explicit iterator(Entry *entry_) noexcept :
+                    entry(entry_) {}
+
+                /// The current slot
+                Entry *entry;
+            };
+
+            /// Construct a view of count slots starting at first
+            constexpr slot_view(Entry *first_, std::size_t count_) noexcept :
+                first(first_), count(count_) {}
+
+            /// Return the number of slots in the view
+            constexpr std::size_t size() const noexcept {
+                return count;
+            }
+
+            /// Returns true if the view has no slots, false otherwise
+            constexpr bool empty() const noexcept {
+                return count == 0;
+            }
+
+            /// Return the projected part of slot i
+            constexpr reference operator[](std::size_t i) const noexcept {
+                return Projection()(first[i]);
+            }
+
+            /// Return an iterator to the start of the view
+            constexpr iterator begin() const noexcept {
+                return iterator(first);
+            }
+
+            /// Return an iterator one-past-the-end of the view
+            constexpr iterator end() const noexcept {
+                return iterator(first + count);
+            }
+
+            /// Return a view of count slots starting at slot offset
+            constexpr slot_view
+            subview(std::size_t offset, std::size_t count_) const noexcept {
+                return slot_view(first + offset, count_);
+            }
+
+        private:
+            /// The first slot in the view
+            Entry *first;
+            /// The number of slots in the view
+            std::size_t count;
+        };
+
+        /// A view of the tickets of the slots in the storage
+        using ticket_view= slot_view<entry_type const, ticket_projection>;
+        /// A view of the values of the slots in the storage. Only slots that
+        /// hold a value, as indicated by the occupancy view, may be accessed.
+        using value_view= slot_view<entry_type, value_projection>;
+        /// A view of the values of the slots in the storage. Only slots that
+        /// hold a value, as indicated by the occupancy view, may be accessed.
+        using const_value_view= slot_view<entry_type const, value_projection>;
+        /// A view of whether or not each slot in the storage holds a value
+        using occupancy_view= slot_view<entry_type const, occupancy_projection>;
+
+        /// A maximal run of consecutive slots that all hold values
+        template <bool is_const> struct dense_run {
+            /// The tickets of the elements in the run
+            ticket_view tickets;
+            /// The values of the elements in the run
+            std::conditional_t<is_const, const_value_view, value_view> values;
+        };
+
+        /// A range of the dense runs in the storage, in ticket order
+        template <bool is_const> class dense_run_range {
+            using entry_ptr=
+                std::conditional_t<is_const, entry_type const *, entry_type *>;
+
+        public:
+            /// An iterator over the dense runs
+            class iterator {
+            public:
+                /// Required iterator typedefs
+                using iterator_category= std::input_iterator_tag;
+                /// Required iterator typedefs
+                using value_type= dense_run<is_const>;
+                /// Required iterator typedefs
+                using reference= value_type;
+                /// Required iterator typedefs
+                using pointer= void;
+                /// Required iterator typedefs
+                using difference_type= std::ptrdiff_t;
+
+                /// Dereference the iterator
+                constexpr value_type operator*() const noexcept {
+                    return {ticket_view(first, last - first),
+                            {first, static_cast<std::size_t>(last - first)}};
+                }
+
+                /// Pre-increment
+                constexpr iterator &operator++() noexcept {
+                    find_run(last);
+                    return *this;
+                }
+
+                /// Post-increment
+                constexpr iterator operator++(int) noexcept {
+                    iterator temp{*this};
+                    ++*this;
+                    return temp;
+                }
+
+                /// Compare iterators for equality
+                friend constexpr bool
+                operator==(iterator const &lhs, iterator const &rhs) noexcept {
+                    return lhs.first == rhs.first;
+                }
+
+                /// Compare iterators for inequality
+                friend constexpr bool
+                operator!=(iterator const &lhs, iterator const &rhs) noexcept {
+                    return lhs.first != rhs.first;
+                }
+
+            private:
+                friend class dense_run_range;
+
+                constexpr iterator(entry_ptr pos, entry_ptr end_) noexcept :
+                    first(pos), last(pos), end(end_) {
+                    find_run(pos);
+                }
+
+                /// Find the first run starting at or after pos
+                constexpr void find_run(entry_ptr pos) noexcept {
+                    for(; pos != end && !pos->second; ++pos)
+                        ;
+                    first= pos;
+                    for(; pos != end && pos->second; ++pos)
+                        ;
+                    last= pos;
+                }
+
+                /// The first slot in the current run
+                entry_ptr first;
+                /// One past the last slot in the current run
+                entry_ptr last;
+                /// One past the last slot in the storage
+                entry_ptr end;
+            };
+
+            /// Return an iterator referring to the first run
+            constexpr iterator begin() const noexcept {
+                return iterator(first, last);
+            }
+
+            /// Return an iterator one-past-the-last run
+            constexpr iterator end() const noexcept {
+                return iterator(last, last);
+            }
+
+        private:
+            friend class ticket_map;
+
+            constexpr dense_run_range(
+                entry_ptr first_, entry_ptr last_) noexcept :
+                first(first_),
+                last(last_) {}
+
+            /// The first slot in the storage
+            entry_ptr first;
+            /// One past the last slot in the storage
+            entry_ptr last;
+        };
+
+        /// A batch of mutations to a map, obtained by calling batch(). Erasing
+        /// an element through the batch just marks it as erased, and inserted
+        /// elements are held in the batch, so no compaction or reallocation
+        /// happens until the batch is committed. Lookups through the batch see
+        /// the pending state. The map must not be modified other than through
+        /// the batch until the batch has been committed.
+        class batch_type {
+        public:
+            /// Insert a new value. It is assigned a new ticket value, which is
+            /// returned.
+            /// Throws overflow_error if the Ticket values have overflowed.
+            Ticket insert(Value v) {
+                return emplace(std::move(v));
+            }
+
+            /// Insert a new value, directly constructing in place. It is
+            /// assigned a new ticket value, which is returned.
+            /// Throws overflow_error if the Ticket values have overflowed.
+            template <typename... Args> Ticket emplace(Args &&... args) {
+                auto id= map->allocate_ticket();
+                auto baseIter=
+                    pending.insert(pending.end(), {id, std::nullopt});
+                baseIter->second.emplace(std::forward<Args>(args)...);
+                ++pendingItems;
+                return id;
+            }
+
+            /// Remove the element with the specified ticket, whether it is in
+            /// the map or pending in the batch. Returns true if an element was
+            /// removed, false otherwise.
+            bool erase(Ticket const &ticket) noexcept {
+                if(auto iter= lookup(pending, ticket); iter != pending.end()) {
+                    iter->second.reset();
+                    --pendingItems;
+                    return true;
+                }
+                if(auto iter= lookup(map->data, ticket);
+                   iter != map->data.end()) {
+                    map->erase_slot(iter);
+                    return true;
+                }
+                return false;
+            }
+
+            /// Find a value by its ticket, whether it is in the map or pending
+            /// in the batch. Throws std::out_of_range if the value was not
+            /// present.
+            Value &operator[](Ticket const &ticket) {
+                if(auto iter= lookup(pending, ticket); iter != pending.end())
+                    return *iter->second;
+                return index(map->data, ticket);
+            }
+
+            /// Return the number of entries for a ticket in the map or pending
+            /// in the batch. The return value is 1 if the ticket is present, 0
+            /// otherwise.
+            std::size_t count(Ticket const &ticket) const noexcept {
+                return (lookup(pending, ticket) != pending.end() ||
+                        lookup(map->data, ticket) != map->data.end()) ?
+                           1 :
+                           0;
+            }
+
+            /// Returns the number of elements in the map, including pending
+            /// inserts and excluding pending erases
+            std::size_t size() const noexcept {
+                return map->size() + pendingItems;
+            }
+
+            /// Apply the pending changes to the map. The map is grown at most
+            /// once and compacted at most once. If this throws, the pending
+            /// inserts are discarded.
+            /// Invalidates any existing iterators into the map.
+            void commit() {
+                if(map) {
+                    std::exchange(map, nullptr)
+                        ->commit_batch(pending, pendingItems);
+                }
+            }
+
+            /// Commit the batch if it hasn't already been committed. If that
+            /// commit fails, the pending inserts are discarded; call commit()
+            /// explicitly to find out about the failure.
+            ~batch_type() {
+                try {
+                    commit();
+                } catch(...) {
+                }
+            }
+
+            /// Move-construct a batch. other no longer refers to the map.
+            batch_type(batch_type &&other) noexcept :
+                map(std::exchange(other.map, nullptr)),
+                pending(std::move(other.pending)),
+                pendingItems(other.pendingItems) {}
+
+            batch_type &operator=(batch_type &&)= delete;
+
+        private:
+            friend class ticket_map;
+
+            /// Construct a batch for the specified map
+            explicit batch_type(ticket_map &map_) noexcept :
+                map(&map_), pendingItems(0) {}
+
+            /// The map being modified
+            ticket_map *map;
+            /// The elements inserted through the batch
+            collection_type pending;
+            /// The number of pending elements that have not been erased
+            std::size_t pendingItems;
+        };
+
+        /// A loader for inserting values into a map from several threads at
+        /// once, obtained by calling bulk_load(). Each producer thread is
+        /// given a region of the storage with its own contiguous range of
+        /// tickets, and constructs its values directly into that region with
+        /// no synchronization. Once all the producers have finished, commit()
+        /// makes the values part of the map.
+        ///
+        /// The map must not be used until the loader has been committed or
+        /// destroyed. If the loader is destroyed without being committed, the
+        /// values constructed so far are destroyed, and the map is left as it
+        /// was, though its capacity may have grown.
+        class bulk_loader {
+        public:
+            /// The part of the storage for one producer
+            class alignas(64) region {
+            public:
+                /// Construct a value at the end of the region from args.
+                /// Returns the ticket for the new value.
+                /// Throws length_error if the region is already full.
+                template <typename... Args>
+                Ticket emplace_back(Args &&... args) {
+                    if(next == last)
+                        throw std::length_error("Bulk load region is full");
+                    next->first= ticket;
+                    next->second.emplace(std::forward<Args>(args)...);
+                    ++next;
+                    bool ignored= false;
+                    return detail::increment_with_overflow_check(
+                        ticket, ignored);
+                }
+
+                /// Insert a value at the end of the region. Returns the
+                /// ticket for the new value.
+                /// Throws length_error if the region is already full.
+                Ticket push_back(Value v) {
+                    return emplace_back(std::move(v));
+                }
+
+                /// Returns the ticket the next value will be given
+                Ticket const &next_ticket() const noexcept {
+                    return ticket;
+                }
+
+                /// Returns the number of values constructed in the region
+                std::size_t size() const noexcept {
+                    return next - first;
+                }
+
+                /// Returns the number of values the region can hold
+                std::size_t capacity() const noexcept {
+                    return last - first;
+                }
+
+            private:
+                friend class ticket_map;
+
+                region(
+                    typename collection_type::pointer first_,
+                    typename collection_type::pointer last_,
+                    Ticket ticket_) noexcept :
+                    first(first_),
+                    next(first_), last(last_), ticket(std::move(ticket_)) {}
+
+                /// The first slot in the region
+                typename collection_type::pointer first;
+                /// The slot for the next value
+                typename collection_type::pointer next;
+                /// One past the last slot in the region
+                typename collection_type::pointer last;
+                /// The ticket for the next value
+                Ticket ticket;
+            };
+
+            /// Return the region for the producer with the specified index, in
+            /// the order the counts were passed to bulk_load()
+            region &operator[](std::size_t producer) noexcept {
+                return regions[producer];
+            }
+
+            /// Return the number of regions
+            std::size_t size() const noexcept {
+                return regions.size();
+            }
+
+            /// Make the values constructed in all the regions part of the map.
+            /// Slots left unfilled by a producer become empty slots, which
+            /// may cause the storage to be compacted. Must only be called once
+            /// all the producers have finished.
+            /// Invalidates any existing iterators into the map.
+            void commit() {
+                if(map)
+                    std::exchange(map, nullptr)->commit_bulk_load(*this);
+            }
+
+            /// Discard the values if the loader was not committed
+            ~bulk_loader() {
+                if(map)
+                    map->abandon_bulk_load(*this);
+            }
+
+            /// Move-construct a loader. other no longer refers to the map.
+            bulk_loader(bulk_loader &&other) noexcept :
+                map(std::exchange(other.map, nullptr)),
+                regions(std::move(other.regions)), oldSize(other.oldSize),
+                endTicket(std::move(other.endTicket)),
+                endOverflow(other.endOverflow) {}
+
+            bulk_loader &operator=(bulk_loader &&)= delete;
+
+        private:
+            friend class ticket_map;
+
+            bulk_loader(
+                ticket_map &map_, std::size_t oldSize_, Ticket endTicket_,
+                bool endOverflow_) noexcept :
+                map(&map_),
+                oldSize(oldSize_), endTicket(std::move(endTicket_)),
+                endOverflow(endOverflow_) {}
+
+            /// The map being loaded
+            ticket_map *map;
+            /// The regions for the producers
+            std::vector<region> regions;
+            /// The number of slots in the storage before the load
+            std::size_t oldSize;
+            /// The next ticket for the map to issue after the load
+            Ticket endTicket;
+            /// The overflow state of the map after the load
+            bool endOverflow;
+        };
+
         /// Construct an empty map
-        constexpr ticket_map() noexcept : nextId(), filledItems(0) {}
+        constexpr ticket_map() noexcept(
+            std::is_nothrow_default_constructible_v<Policy>) :
+            nextId(),
+            filledItems(0) {}
+
+        /// Construct an empty map with the specified policy
+        constexpr explicit ticket_map(Policy policy) :
+            nextId(), filledItems(0), mapPolicy(std::move(policy)) {}
 
         /// Construct a map from a range of elements
         template <typename Iter>
@@ -174,22 +920,54 @@ namespace jss {
 
         /// Move-construct from other. The elements of other are transferred to
         /// *this; other is left empty
-        constexpr ticket_map(ticket_map &&other) noexcept :
-            nextId(std::move(other.nextId)), data(std::move(other.data)),
-            filledItems(std::move(other.filledItems)) {
+        constexpr ticket_map(ticket_map &&other) noexcept(
+            std::is_nothrow_move_constructible_v<Policy>) :
+            nextId(std::move(other.nextId)),
+            data(std::move(other.data)),
+            filledItems(std::move(other.filledItems)),
+            reservations(std::move(other.reservations)),
+            orderStatistics(std::move(other.orderStatistics)),
+            trackOrderStatistics(other.trackOrderStatistics),
+            mapPolicy(std::move(other.mapPolicy)) {
             other.filledItems= 0;
+            other.reservations.clear();
+            other.orderStatistics.clear();
         }
         /// Copy-construct from other. *this will have the same elements and
         /// next ticket value as other.
-        constexpr ticket_map(ticket_map const &other)= default;
-        /// Copy-assign from other
+        constexpr ticket_map(ticket_map const &other) :
+            overflow(other.overflow), nextId(other.nextId), data(other.data),
+            filledItems(other.filledItems), reservations(other.reservations),
+            orderStatistics(other.orderStatistics),
+            trackOrderStatistics(other.trackOrderStatistics),
+            mapPolicy(other.mapPolicy) {
+            storage_changed();
+        }
+        /// Copy-assign from other. The policy is copy-assigned from other's
+        /// policy rather than replaced, so a policy that identifies the map,
+        /// such as registry_policy, keeps doing so.
         constexpr ticket_map &operator=(ticket_map const &other) {
-            ticket_map temp(other);
-            swap(temp);
+            if(this == &other)
+                return *this;
+            auto new_data= other.data;
+            auto new_reservations= other.reservations;
+            auto new_order_statistics= other.orderStatistics;
+            auto new_next= other.nextId;
+            mapPolicy= other.mapPolicy;
+            using std::swap;
+            data.swap(new_data);
+            reservations.swap(new_reservations);
+            orderStatistics.swap(new_order_statistics);
+            swap(nextId, new_next);
+            overflow= other.overflow;
+            filledItems= other.filledItems;
+            trackOrderStatistics= other.trackOrderStatistics;
+            storage_changed();
             return *this;
         }
         /// Move-assign from other
-        constexpr ticket_map &operator=(ticket_map &&other) noexcept {
+        constexpr ticket_map &operator=(ticket_map &&other) noexcept(
+            std::is_nothrow_move_constructible_v<Policy>) {
             ticket_map temp(std::move(other));
             swap(temp);
             return *this;
@@ -233,41 +1011,107 @@ namespace jss {
         /// entry. Invalidates any existing iterators into the map.
         /// Throws overflow_error if the Ticket values have overflowed.
         template <typename... Args> constexpr Ticket emplace(Args &&... args) {
-            if(overflow)
-                throw std::overflow_error(
-                    "Ticket values overflowed; cannot insert");
-            auto id= increment_with_overflow_check(nextId, overflow);
+            auto id= allocate_ticket();
+            emplace_entry(id, std::forward<Args>(args)...);
+            return id;
+        }
 
-            if(!insert_capacity()) {
-                reserve(size() * 2);
+        /// Insert a new value into the map with a ticket supplied by the
+        /// caller, such as when restoring a map that was previously saved.
+        /// The ticket must be greater than any ticket previously issued by the
+        /// map. Tickets subsequently issued by the map follow on from the
+        /// supplied ticket. Returns an iterator referring to the new element.
+        /// Invalidates any existing iterators into the map.
+        /// Throws invalid_argument if the ticket is not greater than every
+        /// ticket previously issued. If this throws, the next ticket issued is
+        /// unchanged.
+        iterator insert_with_ticket(Ticket const &ticket, Value v) {
+            if(overflow || ticket < nextId)
+                throw std::invalid_argument(
+                    "Ticket is not greater than all previous tickets");
+            auto next= ticket;
+            bool next_overflow= false;
+            detail::increment_with_overflow_check(next, next_overflow);
+            auto const iter= emplace_entry(ticket, std::move(v));
+            nextId= std::move(next);
+            overflow= next_overflow;
+            return {iter, this};
+        }
+
+        /// Replace the contents of the map with the ticket/value pairs in the
+        /// range [first,last), which must be in strictly increasing ticket
+        /// order. Tickets subsequently issued by the map are greater than the
+        /// last ticket in the range, and greater than any ticket previously
+        /// issued. All reservations are cancelled.
+        /// Invalidates any existing iterators into the map.
+        /// Throws invalid_argument if the tickets are not in order, in which
+        /// case the map is unchanged.
+        template <typename Iter> void assign_sorted(Iter first, Iter last) {
+            collection_type new_data;
+            if constexpr(std::is_base_of_v<
+                             std::forward_iterator_tag,
+                             typename std::iterator_traits<
+                                 Iter>::iterator_category>) {
+                new_data.reserve(std::distance(first, last));
             }
-            auto baseIter= data.insert(data.end(), {id, std::nullopt});
-            baseIter->second.emplace(std::forward<Args>(args)...);
-            ++filledItems;
-            return id;
+            for(; first != last; ++first) {
+                auto &&entry= *first;
+                auto const &ticket= std::get<0>(entry);
+                if(!new_data.empty() && !(new_data.back().first < ticket))
+                    throw std::invalid_argument(
+                        "Tickets are not in increasing order");
+                new_data.emplace_back(
+                    ticket,
+                    std::get<1>(std::forward<decltype(entry)>(entry)));
+            }
+
+            if(!new_data.empty() && !overflow &&
+               !(new_data.back().first < nextId)) {
+                nextId= new_data.back().first;
+                detail::increment_with_overflow_check(nextId, overflow);
+            }
+            if(trackOrderStatistics)
+                orderStatistics.reserve(new_data.size());
+            data.swap(new_data);
+            filledItems= data.size();
+            reservations.clear();
+            order_statistics_rebuild();
+            storage_changed();
         }
 
         /// Find a value in the map by its ticket. Returns an iterator referring
         /// to the found element, or end() if no element could be found
         constexpr const_iterator find(const Ticket &ticket) const noexcept {
+            [[maybe_unused]] auto const timer=
+                mapPolicy.start_timer(ticket_map_operation::find);
+            mapPolicy.on_operation(ticket_map_operation::find, ticket);
             return {lookup(data, ticket), this};
         }
 
         /// Find a value in the map by its ticket. Returns an iterator referring
         /// to the found element, or end() if no element could be found
         constexpr iterator find(const Ticket &ticket) noexcept {
+            [[maybe_unused]] auto const timer=
+                mapPolicy.start_timer(ticket_map_operation::find);
+            mapPolicy.on_operation(ticket_map_operation::find, ticket);
             return {lookup(data, ticket), this};
         }
 
         /// Find a value in the map by its ticket. Returns a reference to the
         /// found element. Throws std:out_of_range if the value was not present.
         constexpr Value &operator[](const Ticket &ticket) {
+            [[maybe_unused]] auto const timer=
+                mapPolicy.start_timer(ticket_map_operation::find);
+            mapPolicy.on_operation(ticket_map_operation::find, ticket);
             return index(data, ticket);
         }
 
         /// Find a value in the map by its ticket. Returns a reference to the
         /// found element. Throws std:out_of_range if the value was not present.
         constexpr const Value &operator[](const Ticket &ticket) const {
+            [[maybe_unused]] auto const timer=
+                mapPolicy.start_timer(ticket_map_operation::find);
+            mapPolicy.on_operation(ticket_map_operation::find, ticket);
             return index(data, ticket);
         }
 
@@ -327,33 +1171,259 @@ namespace jss {
         /// next ticket value of *this prior to the call, and *this has the
         /// contents and next ticket value of other prior to the call.
         constexpr void swap(ticket_map &other) noexcept {
+            using std::swap;
             data.swap(other.data);
-            std::swap(filledItems, other.filledItems);
-            std::swap(nextId, other.nextId);
+            swap(filledItems, other.filledItems);
+            swap(nextId, other.nextId);
+            reservations.swap(other.reservations);
+            orderStatistics.swap(other.orderStatistics);
+            swap(trackOrderStatistics, other.trackOrderStatistics);
+            swap(mapPolicy, other.mapPolicy);
         }
 
-        /// Remove all elements from *this. Invalidates all iterators into the
-        /// map.
+        /// Remove all elements from *this, and cancel all reservations.
+        /// Invalidates all iterators into the map. The storage is released if
+        /// the policy says so.
         constexpr void clear() noexcept {
             data.clear();
             filledItems= 0;
+            reservations.clear();
+            orderStatistics.clear();
+            release_unused_memory();
+            storage_changed();
         }
 
-        /// Ensure the map has room for at least count items
+        /// Ensure the map has room for at least count items. The storage is
+        /// only reallocated if its capacity is too small; otherwise it is
+        /// compacted in place if that is needed to make room.
         constexpr void reserve(std::size_t count) {
-            if(count > size()) {
-                collection_type new_data;
-                new_data.reserve(count);
-                for(auto &[ticket, value] : data) {
-                    if(value) {
-                        new_data.emplace_back(
-                            std::move(ticket), std::move(value));
-                    }
+            [[maybe_unused]] auto const timer=
+                mapPolicy.start_timer(ticket_map_operation::reserve);
+            if(count + reservations.size() > data.capacity()) {
+                reallocate(count + reservations.size());
+            } else if(count <= size() || count - size() > insert_capacity()) {
+                compact();
+            }
+        }
+
+        /// Compact the storage and reallocate it so the capacity is exactly
+        /// the number of elements. Invalidates all iterators into the map.
+        constexpr void shrink_to_fit() {
+            reallocate(occupied_slots());
+            orderStatistics.shrink_to_fit();
+        }
+
+        /// Return the number of entries the storage can hold without
+        /// reallocating, including entries for erased elements that have not
+        /// yet been compacted away
+        constexpr std::size_t capacity() const noexcept {
+            return data.capacity();
+        }
+
+        /// Return the number of bytes of memory allocated by the map for its
+        /// storage, reservations and order statistics, including unused
+        /// capacity. Memory allocated by the values themselves is not
+        /// included.
+        constexpr std::size_t memory_usage() const noexcept {
+            return data.capacity() * sizeof(entry_type) +
+                   reservations.capacity() * sizeof(reservation_type) +
+                   orderStatistics.capacity() * sizeof(std::size_t);
+        }
+
+        /// Reserve a ticket for a value that will be supplied later by calling
+        /// fulfil(). A slot for the value is appended to the storage, but the
+        /// map does not contain an element for the ticket until the
+        /// reservation is fulfilled. Returns the reserved ticket.
+        /// Invalidates any existing iterators into the map.
+        /// Throws overflow_error if the Ticket values have overflowed.
+        Ticket reserve_ticket() {
+            auto id= allocate_ticket();
+            auto slot= append_slot(id);
+            try {
+                reservations.emplace_back(id, slot - data.begin());
+            } catch(...) {
+                remove_last_slot();
+                throw;
+            }
+            return id;
+        }
+
+        /// Construct the value for a ticket previously returned from
+        /// reserve_ticket() directly in its reserved slot. Returns an iterator
+        /// referring to the new element.
+        /// Throws std::out_of_range if the ticket is not reserved.
+        template <typename... Args>
+        iterator fulfil(Ticket const &ticket, Args &&... args) {
+            auto reservation= find_reservation(ticket);
+            if(reservation == reservations.end())
+                throw std::out_of_range("No reservation for specified ticket");
+            auto slot= data.begin() + reservation->second;
+            slot->second.emplace(std::forward<Args>(args)...);
+            mapPolicy.on_operation(ticket_map_operation::insert, ticket);
+            ++filledItems;
+            order_statistics_add(reservation->second);
+            reservations.erase(reservation);
+            return {slot, this};
+        }
+
+        /// Cancel the reservation for a ticket previously returned from
+        /// reserve_ticket(). Returns true if the ticket was reserved, false
+        /// otherwise.
+        /// Invalidates any existing iterators into the map.
+        bool cancel_reservation(Ticket const &ticket) noexcept {
+            auto reservation= find_reservation(ticket);
+            if(reservation == reservations.end())
+                return false;
+            reservations.erase(reservation);
+            if(needs_compaction())
+                compact();
+            return true;
+        }
+
+        /// Return the number of outstanding reservations
+        constexpr std::size_t reserved_count() const noexcept {
+            return reservations.size();
+        }
+
+        /// Return a view of the tickets of all the slots in the storage,
+        /// including those that do not hold values. The view is invalidated by
+        /// anything that invalidates iterators.
+        ticket_view tickets() const noexcept {
+            return {data.data(), data.size()};
+        }
+
+        /// Return a view of the values of all the slots in the storage. Only
+        /// slots that hold values, as indicated by occupancy(), may be
+        /// accessed. The view is invalidated by anything that invalidates
+        /// iterators.
+        value_view values() noexcept {
+            return {data.data(), data.size()};
+        }
+
+        /// Return a view of the values of all the slots in the storage. Only
+        /// slots that hold values, as indicated by occupancy(), may be
+        /// accessed. The view is invalidated by anything that invalidates
+        /// iterators.
+        const_value_view values() const noexcept {
+            return {data.data(), data.size()};
+        }
+
+        /// Return a view of whether or not each slot in the storage holds a
+        /// value. The view is invalidated by anything that invalidates
+        /// iterators.
+        occupancy_view occupancy() const noexcept {
+            return {data.data(), data.size()};
+        }
+
+        /// Return a range of the maximal runs of slots that hold values, in
+        /// ticket order. Loops over the values of a run need no checks for
+        /// empty slots. The range is invalidated by anything that invalidates
+        /// iterators.
+        dense_run_range<false> dense_runs() noexcept {
+            return {data.data(), data.data() + data.size()};
+        }
+
+        /// Return a range of the maximal runs of slots that hold values, in
+        /// ticket order. Loops over the values of a run need no checks for
+        /// empty slots. The range is invalidated by anything that invalidates
+        /// iterators.
+        dense_run_range<true> dense_runs() const noexcept {
+            return {data.data(), data.data() + data.size()};
+        }
+
+        /// Start maintaining an index of the live elements, so that rank() and
+        /// select() take O(log n) time rather than O(n). Once enabled, the
+        /// index is updated on every insert and erase, at a cost of O(log n)
+        /// time and an extra std::size_t per slot.
+        void enable_order_statistics() {
+            if(!trackOrderStatistics) {
+                orderStatistics.reserve(data.capacity());
+                trackOrderStatistics= true;
+                order_statistics_rebuild();
+            }
+        }
+
+        /// Return the number of elements with tickets less than the specified
+        /// ticket. The ticket need not be in the map.
+        std::size_t rank(Ticket const &ticket) const noexcept {
+            auto const pos= lower_bound(data, ticket) - data.begin();
+            if(trackOrderStatistics)
+                return order_statistics_prefix(pos);
+            return std::count_if(
+                data.begin(), data.begin() + pos,
+                [](auto &entry) { return entry.second.has_value(); });
+        }
+
+        /// Return an iterator referring to the element at position k in ticket
+        /// order, counting from zero, or end() if k >= size()
+        iterator select(std::size_t k) noexcept {
+            return {select_entry(data, k), this};
+        }
+
+        /// Return an iterator referring to the element at position k in ticket
+        /// order, counting from zero, or end() if k >= size()
+        const_iterator select(std::size_t k) const noexcept {
+            return {select_entry(data, k), this};
+        }
+
+        /// Start a batch of mutations. See batch_type.
+        batch_type batch() noexcept {
+            return batch_type(*this);
+        }
+
+        /// Start loading values from several producers at once. counts holds
+        /// the number of values each producer will supply. Each producer is
+        /// assigned a contiguous range of tickets, following on from the
+        /// previous producer's range, and room for its values is allocated
+        /// in the storage. See bulk_loader.
+        /// Throws overflow_error if there are not enough Ticket values left
+        /// for all the values, in which case the map is unchanged.
+        bulk_loader bulk_load(std::vector<std::size_t> const &counts) {
+            std::vector<Ticket> starts;
+            starts.reserve(counts.size());
+            auto ticket= nextId;
+            auto newOverflow= overflow;
+            std::size_t total= 0;
+            try {
+                for(auto count : counts) {
+                    starts.push_back(ticket);
+                    detail::advance_with_overflow_check(
+                        ticket, count, newOverflow);
+                    total+= count;
                 }
-                data.swap(new_data);
-            } else {
+            } catch(std::overflow_error &) {
+                JSS_TICKET_MAP_PROBE1(overflow, size());
+                throw;
+            }
+
+            bulk_loader loader(*this, data.size(), ticket, newOverflow);
+            loader.regions.reserve(counts.size());
+            if(total > data.capacity() - occupied_slots()) {
+                reallocate(occupied_slots() + total);
+            } else if(total > insert_capacity()) {
                 compact();
             }
+            if(trackOrderStatistics)
+                orderStatistics.reserve(data.size() + total);
+            loader.oldSize= data.size();
+            data.resize(data.size() + total);
+            auto slot= data.data() + loader.oldSize;
+            for(std::size_t i= 0; i != counts.size(); ++i) {
+                loader.regions.push_back(
+                    {slot, slot + counts[i], std::move(starts[i])});
+                slot+= counts[i];
+            }
+            return loader;
+        }
+
+        /// Return the policy object
+        constexpr Policy &get_policy() noexcept {
+            return mapPolicy;
+        }
+
+        /// Return the policy object
+        constexpr Policy const &get_policy() const noexcept {
+            return mapPolicy;
         }
 
         /// Return the maximum number of items that can be inserted without
@@ -365,10 +1435,288 @@ namespace jss {
         /// Return the number of entries for a ticket in the container. The
         /// return value is 1 if the ticket is in the container, 0 otherwise.
         constexpr std::size_t count(Ticket const &ticket) const noexcept {
+            [[maybe_unused]] auto const timer=
+                mapPolicy.start_timer(ticket_map_operation::find);
+            mapPolicy.on_operation(ticket_map_operation::find, ticket);
             return (lookup(data, ticket) == data.end()) ? 0 : 1;
         }
 
     private:
+        friend struct detail::ticket_map_parallel_access;
+        friend struct detail::ticket_map_background_access;
+
+        /// Allocate the next ticket value.
+        /// Throws overflow_error if the Ticket values have overflowed.
+        Ticket allocate_ticket() {
+            if(overflow) {
+                JSS_TICKET_MAP_PROBE1(overflow, size());
+                throw std::overflow_error(
+                    "Ticket values overflowed; cannot insert");
+            }
+            return detail::increment_with_overflow_check(nextId, overflow);
+        }
+
+        /// A reserved ticket, along with the index of its slot in the storage
+        using reservation_type= std::pair<Ticket, std::size_t>;
+
+        /// Find the reservation for a ticket. Returns reservations.end() if
+        /// there is none.
+        typename std::vector<reservation_type>::iterator
+        find_reservation(Ticket const &ticket) noexcept {
+            auto pos= std::lower_bound(
+                reservations.begin(), reservations.end(), ticket,
+                [](auto &reservation, const Ticket &ticket) {
+                    return reservation.first < ticket;
+                });
+            if(pos == reservations.end() || pos->first != ticket)
+                return reservations.end();
+            return pos;
+        }
+
+        /// Returns the number of slots that must be kept when compacting: the
+        /// live elements and the reserved slots
+        std::size_t occupied_slots() const noexcept {
+            return filledItems + reservations.size();
+        }
+
+        /// Call f for each entry that must be kept when compacting, in order.
+        /// f must place the entries in order at the start of the new storage,
+        /// so the slot indices of the reservations are updated to match.
+        template <typename F> void for_each_occupied(F f) {
+            auto reservation= reservations.begin();
+            std::size_t new_index= 0;
+            for(std::size_t i= 0; i != data.size(); ++i) {
+                if(reservation != reservations.end() &&
+                   reservation->second == i) {
+                    reservation++->second= new_index;
+                } else if(!data[i].second) {
+                    continue;
+                }
+                f(data[i]);
+                ++new_index;
+            }
+        }
+
+        /// Append a new entry with the specified ticket, constructing the value
+        /// in place. Returns an iterator referring to the new entry.
+        template <typename... Args>
+        typename collection_type::iterator
+        emplace_entry(Ticket const &id, Args &&... args) {
+            [[maybe_unused]] auto const timer=
+                mapPolicy.start_timer(ticket_map_operation::insert);
+            auto baseIter= append_slot(id);
+            try {
+                baseIter->second.emplace(std::forward<Args>(args)...);
+            } catch(...) {
+                remove_last_slot();
+                throw;
+            }
+            mapPolicy.on_operation(ticket_map_operation::insert, id);
+            ++filledItems;
+            order_statistics_add(baseIter - data.begin());
+            return baseIter;
+        }
+
+        /// Append an empty slot with the specified ticket, making room if
+        /// necessary. If at least a quarter of the storage is empty slots then
+        /// it is compacted in place, so inserting doesn't allocate while the
+        /// map stays below three quarters of its capacity; otherwise it is
+        /// grown. Returns an iterator referring to the new slot.
+        typename collection_type::iterator append_slot(Ticket const &id) {
+            if(!insert_capacity()) {
+                auto const empty_slots= data.size() - occupied_slots();
+                if(empty_slots && empty_slots >= data.capacity() / 4)
+                    compact();
+                else
+                    reserve(mapPolicy.grow_capacity(size(), data.capacity()));
+            }
+            auto slot= data.insert(data.end(), {id, std::nullopt});
+            try {
+                order_statistics_append(false);
+            } catch(...) {
+                data.pop_back();
+                throw;
+            }
+            return slot;
+        }
+
+        /// Remove the last slot, which must be empty
+        void remove_last_slot() noexcept {
+            data.pop_back();
+            if(trackOrderStatistics)
+                orderStatistics.pop_back();
+        }
+
+        /// Find the entry for the element at position k in ticket order
+        template <typename Collection>
+        auto select_entry(Collection &storage, std::size_t k) const noexcept {
+            if(k >= filledItems)
+                return storage.end();
+            if(!trackOrderStatistics) {
+                auto iter= next_valid(storage.begin());
+                for(; k; --k) {
+                    iter= next_valid(++iter);
+                }
+                return iter;
+            }
+            // Descend the Fenwick tree to find the longest run of slots from
+            // the start holding at most k elements. The next slot holds
+            // element k.
+            std::size_t const slots= orderStatistics.size();
+            std::size_t step= 1;
+            while(step <= slots / 2) {
+                step*= 2;
+            }
+            std::size_t pos= 0;
+            for(; step; step/= 2) {
+                if(pos + step <= slots &&
+                   orderStatistics[pos + step - 1] <= k) {
+                    pos+= step;
+                    k-= orderStatistics[pos - 1];
+                }
+            }
+            return storage.begin() + pos;
+        }
+
+        /// Return the lowest set bit of i
+        static constexpr std::size_t lowest_set_bit(std::size_t i) noexcept {
+            return i & (~i + 1);
+        }
+
+        /// Return the number of live elements in the first count slots
+        std::size_t order_statistics_prefix(std::size_t count) const noexcept {
+            std::size_t total= 0;
+            for(; count; count-= lowest_set_bit(count)) {
+                total+= orderStatistics[count - 1];
+            }
+            return total;
+        }
+
+        /// Record in the index that the specified slot now holds an element
+        void order_statistics_add(std::size_t slot) noexcept {
+            if(trackOrderStatistics) {
+                for(auto i= slot + 1; i <= orderStatistics.size();
+                    i+= lowest_set_bit(i)) {
+                    ++orderStatistics[i - 1];
+                }
+            }
+        }
+
+        /// Record in the index that the element in the specified slot has been
+        /// erased
+        void order_statistics_remove(std::size_t slot) noexcept {
+            if(trackOrderStatistics) {
+                for(auto i= slot + 1; i <= orderStatistics.size();
+                    i+= lowest_set_bit(i)) {
+                    --orderStatistics[i - 1];
+                }
+            }
+        }
+
+        /// Add a slot to the end of the index
+        void order_statistics_append(bool filled) {
+            if(trackOrderStatistics) {
+                auto const i= orderStatistics.size() + 1;
+                orderStatistics.push_back(
+                    (filled ? 1 : 0) + order_statistics_prefix(i - 1) -
+                    order_statistics_prefix(i - lowest_set_bit(i)));
+            }
+        }
+
+        /// Rebuild the index from the storage. The index never needs more room
+        /// than it had before, since compacting only ever removes slots, and
+        /// growing reserves room in the index.
+        void order_statistics_rebuild() noexcept {
+            if(!trackOrderStatistics)
+                return;
+            orderStatistics.resize(data.size());
+            for(std::size_t i= 0; i != data.size(); ++i) {
+                orderStatistics[i]= data[i].second ? 1 : 0;
+            }
+            for(std::size_t i= 1; i <= data.size(); ++i) {
+                auto const parent= i + lowest_set_bit(i);
+                if(parent <= data.size())
+                    orderStatistics[parent - 1]+= orderStatistics[i - 1];
+            }
+        }
+
+        /// Merge the pending inserts from a batch into the storage, growing or
+        /// compacting the storage as needed beforehand
+        void commit_batch(collection_type &pending, std::size_t pendingItems) {
+            JSS_TICKET_MAP_PROBE2(batch_start, size(), pendingItems);
+            auto const total= size() + pendingItems;
+            if(pendingItems > data.capacity() - occupied_slots()) {
+                reallocate(std::max(
+                    mapPolicy.grow_capacity(total, data.capacity()),
+                    total + reservations.size()));
+            } else if(pendingItems > insert_capacity() || needs_compaction()) {
+                compact();
+            }
+            if(trackOrderStatistics)
+                orderStatistics.reserve(data.size() + pendingItems);
+            auto const old_slots= data.size();
+            try {
+                for(auto &entry : pending) {
+                    if(entry.second) {
+                        data.push_back(std::move(entry));
+                        order_statistics_append(true);
+                    }
+                }
+            } catch(...) {
+                while(data.size() != old_slots) {
+                    remove_last_slot();
+                }
+                pending.clear();
+                storage_changed();
+                throw;
+            }
+            for(auto slot= old_slots; slot != data.size(); ++slot) {
+                mapPolicy.on_operation(
+                    ticket_map_operation::insert, data[slot].first);
+            }
+            filledItems= total;
+            pending.clear();
+            if(needs_shrink())
+                release_unused_memory();
+            storage_changed();
+            JSS_TICKET_MAP_PROBE1(batch_end, size());
+        }
+
+        /// Make the values constructed by the producers part of the map,
+        /// filling in the tickets for any slots the producers left empty
+        void commit_bulk_load(bulk_loader &loader) {
+            JSS_TICKET_MAP_PROBE2(
+                bulk_load_start, size(), data.size() - loader.oldSize);
+            std::size_t loaded= 0;
+            for(auto &region : loader.regions) {
+                loaded+= region.size();
+                for(auto slot= region.first; slot != region.next; ++slot) {
+                    if(slot->second)
+                        mapPolicy.on_operation(
+                            ticket_map_operation::insert, slot->first);
+                }
+                bool ignored= false;
+                for(auto slot= region.next; slot != region.last; ++slot) {
+                    slot->first= detail::increment_with_overflow_check(
+                        region.ticket, ignored);
+                }
+            }
+            filledItems+= loaded;
+            nextId= std::move(loader.endTicket);
+            overflow= loader.endOverflow;
+            order_statistics_rebuild();
+            if(needs_compaction())
+                compact();
+            storage_changed();
+            JSS_TICKET_MAP_PROBE1(bulk_load_end, size());
+        }
+
+        /// Discard the values constructed by the producers, and remove their
+        /// slots from the storage
+        void abandon_bulk_load(bulk_loader &loader) noexcept {
+            data.erase(data.begin() + loader.oldSize, data.end());
+        }
+
         /// Find the next valid iterator into the map
         template <typename Iter>
         constexpr Iter next_valid(Iter iter) const noexcept {
@@ -377,35 +1725,60 @@ namespace jss {
             return iter;
         }
 
+        /// Erase the entry in the specified slot, without looking for the
+        /// next entry or compacting the storage
+        constexpr void
+        erase_slot(typename collection_type::iterator iter) noexcept {
+            mapPolicy.on_operation(ticket_map_operation::erase, iter->first);
+            iter->second.reset();
+            order_statistics_remove(iter - data.begin());
+            --filledItems;
+        }
+
         /// Erase an entry referenced by an iterator into the internal vector
         constexpr typename collection_type::iterator
         erase_entry(typename collection_type::iterator iter) {
             if(iter != data.end()) {
-                iter->second.reset();
+                [[maybe_unused]] auto const timer=
+                    mapPolicy.start_timer(ticket_map_operation::erase);
+                erase_slot(iter);
                 iter= next_valid(iter);
-                --filledItems;
-                if(needs_compaction()) {
+                if(needs_compaction() || needs_shrink()) {
                     auto ticket= iter != data.end() ? iter->first :
                                                       std::optional<Ticket>();
-                    compact();
+                    if(needs_shrink())
+                        release_unused_memory();
+                    else
+                        compact();
                     iter= ticket ? lookup(data, *ticket) : data.end();
                 }
             }
             return iter;
         }
 
-        /// Find an element based on a ticket value
+        /// Find the first entry with a ticket that is not less than the
+        /// specified ticket
         template <typename Collection>
         static constexpr std::conditional_t<
             std::is_const_v<std::remove_reference_t<Collection>>,
             typename collection_type::const_iterator,
             typename collection_type::iterator>
-        lookup(Collection &data, Ticket const &ticket) noexcept {
-            auto pos= std::lower_bound(
+        lower_bound(Collection &data, Ticket const &ticket) noexcept {
+            return std::lower_bound(
                 data.begin(), data.end(), ticket,
                 [](auto &value, const Ticket &ticket) {
                     return value.first < ticket;
                 });
+        }
+
+        /// Find an element based on a ticket value
+        template <typename Collection>
+        static constexpr std::conditional_t<
+            std::is_const_v<std::remove_reference_t<Collection>>,
+            typename collection_type::const_iterator,
+            typename collection_type::iterator>
+        lookup(Collection &data, Ticket const &ticket) noexcept {
+            auto pos= lower_bound(data, ticket);
 
             if(pos == data.end() || pos->first != ticket || !pos->second)
                 return data.end();
@@ -427,53 +1800,114 @@ namespace jss {
         /// Returns true if the container has too many empty slot, false
         /// otherwise
         bool needs_compaction() const noexcept {
-            return filledItems < (data.size() / 2);
+            return mapPolicy.needs_compaction(occupied_slots(), data.size());
         }
 
-        /// Compact the container to remove all empty slots.
-        void compact() {
-            data.erase(
-                std::remove_if(
-                    data.begin(), data.end(),
-                    [](auto &entry) { return !entry.second; }),
-                data.end());
+        /// Returns true if the policy wants the storage to be reduced and the
+        /// elements can be moved without throwing, false otherwise
+        bool needs_shrink() const noexcept {
+            return std::is_nothrow_move_constructible_v<entry_type> &&
+                   mapPolicy.shrink_capacity(size(), data.capacity()) <
+                       data.capacity();
         }
 
-        /// Increment a ticket and check for overflow (generic)
-        template <typename T>
-        static std::enable_if_t<!std::is_integral_v<T>, T>
-        increment_with_overflow_check(T &value, bool &overflow) {
-            auto id= value++;
-            if(value < id || value == id)
-                overflow= true;
-            return id;
+        /// Move the live elements into new storage with room for count
+        /// elements
+        void reallocate(std::size_t count) {
+            collection_type new_data;
+            new_data.reserve(count);
+            if(trackOrderStatistics)
+                orderStatistics.reserve(count);
+            move_live_entries(new_data);
         }
 
-        /// Increment a ticket and check for overflow (integral)
-        template <typename T>
-        static std::enable_if_t<std::is_integral_v<T>, T>
-        increment_with_overflow_check(T &value, bool &overflow) {
-            auto id= value;
-            if(value == std::numeric_limits<T>::max())
-                overflow= true;
-            else
-                ++value;
-            return id;
+        /// Move the live elements and reserved slots into new_data, and make
+        /// that the storage
+        void move_live_entries(collection_type &new_data) {
+            JSS_TICKET_MAP_PROBE3(
+                reallocate_start, data.size(),
+                data.size() - occupied_slots(), new_data.capacity());
+            for_each_occupied([&](auto &entry) {
+                if(entry.second)
+                    mapPolicy.on_compaction_move(entry.first);
+                new_data.push_back(std::move(entry));
+            });
+            data.swap(new_data);
+            order_statistics_rebuild();
+            storage_changed();
+            JSS_TICKET_MAP_PROBE2(
+                reallocate_end, data.size(), data.capacity());
+        }
+
+        /// Reduce the capacity of the storage if the policy says so. Releasing
+        /// memory is optional, so if the new storage cannot be allocated, or
+        /// moving the elements into it might throw, then the existing storage
+        /// is kept.
+        void release_unused_memory() noexcept {
+            if constexpr(std::is_nothrow_move_constructible_v<entry_type>) {
+                auto const target=
+                    mapPolicy.shrink_capacity(size(), data.capacity());
+                if(target >= data.capacity())
+                    return;
+                collection_type new_data;
+                try {
+                    new_data.reserve(std::max(target, occupied_slots()));
+                } catch(std::bad_alloc &) {
+                    return;
+                }
+                move_live_entries(new_data);
+            }
+        }
+
+        /// Compact the container to remove all empty slots other than
+        /// reserved ones.
+        void compact() {
+            [[maybe_unused]] auto const timer=
+                mapPolicy.start_timer(ticket_map_operation::compact);
+            JSS_TICKET_MAP_PROBE2(
+                compact_start, data.size(), data.size() - occupied_slots());
+            auto dest= data.begin();
+            [[maybe_unused]] std::size_t moved= 0;
+            for_each_occupied([&](auto &entry) {
+                if(&*dest != &entry) {
+                    if(entry.second)
+                        mapPolicy.on_compaction_move(entry.first);
+                    *dest= std::move(entry);
+                    ++moved;
+                }
+                ++dest;
+            });
+            data.erase(dest, data.end());
+            order_statistics_rebuild();
+            storage_changed();
+            JSS_TICKET_MAP_PROBE2(compact_end, data.size(), moved);
+        }
+
+        /// Tell the policy the storage has changed
+        void storage_changed() const noexcept {
+            mapPolicy.on_storage_changed(*this);
         }
 
         bool overflow= false;
         Ticket nextId;
         collection_type data;
         std::size_t filledItems;
+        /// The outstanding reservations, in ticket order
+        std::vector<reservation_type> reservations;
+        /// A Fenwick tree over the occupancy of the slots, if
+        /// trackOrderStatistics is true
+        std::vector<std::size_t> orderStatistics;
+        bool trackOrderStatistics= false;
+        Policy mapPolicy;
     };
 } // namespace jss
 
 namespace std {
 
-    template <typename Ticket, typename Value>
+    template <typename Ticket, typename Value, typename Policy>
     void swap(
-        jss::ticket_map<Ticket, Value> &lhs,
-        jss::ticket_map<Ticket, Value> &rhs) noexcept {
+        jss::ticket_map<Ticket, Value, Policy> &lhs,
+        jss::ticket_map<Ticket, Value, Policy> &rhs) noexcept {
         lhs.swap(rhs);
     }
 } // namespace std
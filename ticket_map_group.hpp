@@ -0,0 +1,183 @@
+// This code is released under the Boost Software License
+// https://www.boost.org/LICENSE_1_0.txt
+// (C) Copyright 2021 Anthony Williams
+
+#pragma once
+
+#include "columnar_ticket_map.hpp"
+#include <cstdlib>
+#include <tuple>
+#include <type_traits>
+#include <iterator>
+
+namespace jss {
+
+    /// A group of maps from the same tickets to values of each of the Columns
+    /// types. Each ticket identifies one row with a value in every column. The
+    /// tickets are stored once, so a single lookup finds the values in all
+    /// columns, and the columns are compacted together. Each column can also
+    /// be iterated on its own, as if it were a separate map.
+    template <typename Ticket, typename... Columns>
+    class ticket_map_group
+        : public columnar_ticket_map<Ticket, std::tuple<Columns...>> {
+        using base= columnar_ticket_map<Ticket, std::tuple<Columns...>>;
+
+    public:
+        /// The type of column I
+        template <std::size_t I>
+        using column_type= typename base::template field_type<I>;
+
+        /// A range of the tickets and values for one column
+        template <std::size_t I, bool is_const> class column_range {
+            using value_reference= std::conditional_t<
+                is_const, column_type<I> const &, column_type<I> &>;
+            using column_view= typename base::template column_view<
+                std::remove_reference_t<value_reference>>;
+
+        public:
+            /// The elements of the range: a ticket and the value for that
+            /// ticket in the column
+            struct value_type {
+                /// A reference to the ticket value for this element
+                Ticket const &ticket;
+                /// A reference to the value in the column for this element
+                value_reference value;
+            };
+
+            /// An iterator over the range
+            class iterator {
+            public:
+                /// Required iterator typedefs
+                using iterator_category= std::input_iterator_tag;
+                /// Required iterator typedefs
+                using value_type= column_range::value_type;
+                /// Required iterator typedefs
+                using reference= value_type;
+                /// Required iterator typedefs
+                using pointer= void;
+                /// Required iterator typedefs
+                using difference_type= void;
+
+                /// Dereference the iterator
+                value_type operator*() const noexcept {
+                    return {range->tickets[slot], range->values[slot]};
+                }
+
+                /// Pre-increment
+                iterator &operator++() noexcept {
+                    slot= range->next_valid(slot + 1);
+                    return *this;
+                }
+
+                /// Post-increment
+                iterator operator++(int) noexcept {
+                    iterator temp{*this};
+                    ++*this;
+                    return temp;
+                }
+
+                /// Compare iterators for equality
+                friend bool
+                operator==(iterator const &lhs, iterator const &rhs) noexcept {
+                    return lhs.slot == rhs.slot;
+                }
+
+                /// Compare iterators for inequality
+                friend bool
+                operator!=(iterator const &lhs, iterator const &rhs) noexcept {
+                    return lhs.slot != rhs.slot;
+                }
+
+            private:
+                friend class column_range;
+
+                iterator(
+                    column_range const *range_, std::size_t slot_) noexcept :
+                    range(range_),
+                    slot(slot_) {}
+
+                /// The range being iterated
+                column_range const *range;
+                /// The current slot
+                std::size_t slot;
+            };
+
+            /// Returns an iterator to the first element in the column
+            iterator begin() const noexcept {
+                return {this, next_valid(0)};
+            }
+
+            /// Returns an iterator one-past-the-end of the column
+            iterator end() const noexcept {
+                return {this, tickets.size()};
+            }
+
+        private:
+            friend class ticket_map_group;
+
+            column_range(
+                typename base::template column_view<Ticket const> tickets_,
+                typename base::template column_view<unsigned char const>
+                    occupancy_,
+                column_view values_) noexcept :
+                tickets(tickets_),
+                occupancy(occupancy_), values(values_) {}
+
+            /// Find the first slot at or after slot that holds an element
+            std::size_t next_valid(std::size_t slot) const noexcept {
+                for(; slot != occupancy.size() && !occupancy[slot]; ++slot)
+                    ;
+                return slot;
+            }
+
+            /// The tickets of the slots
+            typename base::template column_view<Ticket const> tickets;
+            /// The occupancy of the slots
+            typename base::template column_view<unsigned char const> occupancy;
+            /// The values in the column
+            column_view values;
+        };
+
+        using base::base;
+        using base::insert;
+
+        /// Insert a new row into the group, with the specified value for each
+        /// column. It is assigned a new ticket value. Returns the ticket for
+        /// the new row.
+        /// Invalidates any existing iterators into the group.
+        /// Throws overflow_error if the Ticket values have overflowed.
+        Ticket insert(Columns... values) {
+            return this->emplace(std::move(values)...);
+        }
+
+        /// Find the value in column I for a ticket. Throws std::out_of_range if
+        /// there is no row for the ticket.
+        template <std::size_t I> column_type<I> &get(Ticket const &ticket) {
+            return (*this)[ticket].template get<I>();
+        }
+
+        /// Find the value in column I for a ticket. Throws std::out_of_range if
+        /// there is no row for the ticket.
+        template <std::size_t I>
+        column_type<I> const &get(Ticket const &ticket) const {
+            return (*this)[ticket].template get<I>();
+        }
+
+        /// Return a range of the tickets and values of column I, in ticket
+        /// order. The range is invalidated by anything that invalidates
+        /// iterators.
+        template <std::size_t I> column_range<I, false> entries() noexcept {
+            return {this->tickets(), this->occupancy(),
+                    this->template column<I>()};
+        }
+
+        /// Return a range of the tickets and values of column I, in ticket
+        /// order. The range is invalidated by anything that invalidates
+        /// iterators.
+        template <std::size_t I>
+        column_range<I, true> entries() const noexcept {
+            return {this->tickets(), this->occupancy(),
+                    this->template column<I>()};
+        }
+    };
+} // namespace jss
@@ -0,0 +1,252 @@
+// This code is released under the Boost Software License
+// https://www.boost.org/LICENSE_1_0.txt
+// (C) Copyright 2021 Anthony Williams
+
+#pragma once
+
+#include "ticket_map.hpp"
+#include <cstdlib>
+#include <algorithm>
+#include <type_traits>
+#include <iterator>
+#include <utility>
+
+namespace jss {
+
+    /// The kinds of join supported by join_view
+    enum class join_kind {
+        /// Only tickets present in both maps
+        inner,
+        /// All tickets in the left-hand map, with the right-hand value if there
+        /// is one
+        left
+    };
+
+    /// A view of two ticket maps with the same Ticket type, matching up the
+    /// elements with the same ticket. Both maps are walked in ticket order at
+    /// the same time, skipping runs of non-matching tickets with a galloping
+    /// search, so iterating the whole view takes O(n+m) time at most, and
+    /// much less when one map is much smaller than the other.
+    ///
+    /// LhsMap and RhsMap are ticket_map specializations, optionally const. The
+    /// view is invalidated by anything that invalidates iterators into either
+    /// map.
+    template <typename LhsMap, typename RhsMap, join_kind kind>
+    class join_view {
+        using lhs_tickets= decltype(std::declval<LhsMap &>().tickets());
+        using lhs_occupancy= decltype(std::declval<LhsMap &>().occupancy());
+        using lhs_values= decltype(std::declval<LhsMap &>().values());
+        using rhs_tickets= decltype(std::declval<RhsMap &>().tickets());
+        using rhs_occupancy= decltype(std::declval<RhsMap &>().occupancy());
+        using rhs_values= decltype(std::declval<RhsMap &>().values());
+
+        using ticket_type= std::remove_cv_t<
+            std::remove_reference_t<typename lhs_tickets::reference>>;
+
+        static_assert(
+            std::is_same_v<
+                ticket_type, std::remove_cv_t<std::remove_reference_t<
+                                 typename rhs_tickets::reference>>>,
+            "Both maps must have the same Ticket type");
+
+    public:
+        /// The elements of the view
+        struct value_type {
+            /// A reference to the ticket value for this element
+            ticket_type const &ticket;
+            /// A reference to the left-hand value for this element
+            typename lhs_values::reference lhs;
+            /// The right-hand value for this element: a reference for an inner
+            /// join, and a pointer that is null if there is no right-hand value
+            /// for a left join
+            std::conditional_t<
+                kind == join_kind::inner, typename rhs_values::reference,
+                std::remove_reference_t<typename rhs_values::reference> *>
+                rhs;
+        };
+
+        /// An iterator over the view
+        class iterator {
+        public:
+            /// Required iterator typedefs
+            using iterator_category= std::input_iterator_tag;
+            /// Required iterator typedefs
+            using value_type= join_view::value_type;
+            /// Required iterator typedefs
+            using reference= value_type;
+            /// Required iterator typedefs
+            using pointer= void;
+            /// Required iterator typedefs
+            using difference_type= void;
+
+            /// Dereference the iterator
+            value_type operator*() const noexcept {
+                auto &view= *join;
+                if constexpr(kind == join_kind::inner) {
+                    return {view.lhsTickets[lhs], view.lhsValues[lhs],
+                            view.rhsValues[rhs]};
+                } else {
+                    return {view.lhsTickets[lhs], view.lhsValues[lhs],
+                            rhs_matches() ? &view.rhsValues[rhs] : nullptr};
+                }
+            }
+
+            /// Pre-increment
+            iterator &operator++() noexcept {
+                ++lhs;
+                if constexpr(kind == join_kind::inner)
+                    ++rhs;
+                find_match();
+                return *this;
+            }
+
+            /// Post-increment
+            iterator operator++(int) noexcept {
+                iterator temp{*this};
+                ++*this;
+                return temp;
+            }
+
+            /// Compare iterators for equality
+            friend bool
+            operator==(iterator const &lhs, iterator const &rhs) noexcept {
+                return lhs.lhs == rhs.lhs;
+            }
+
+            /// Compare iterators for inequality
+            friend bool
+            operator!=(iterator const &lhs, iterator const &rhs) noexcept {
+                return lhs.lhs != rhs.lhs;
+            }
+
+        private:
+            friend class join_view;
+
+            iterator(
+                join_view const *join_, std::size_t lhs_,
+                std::size_t rhs_) noexcept :
+                join(join_),
+                lhs(lhs_), rhs(rhs_) {
+                find_match();
+            }
+
+            /// Returns true if the current right-hand slot holds the ticket
+            /// for the current left-hand slot
+            bool rhs_matches() const noexcept {
+                auto &view= *join;
+                return rhs != view.rhsTickets.size() &&
+                       view.rhsTickets[rhs] == view.lhsTickets[lhs] &&
+                       view.rhsOccupancy[rhs];
+            }
+
+            /// Move forward to the next element of the view, starting from the
+            /// current position
+            void find_match() noexcept {
+                auto &view= *join;
+                auto const lhs_end= view.lhsTickets.size();
+                auto const rhs_end= view.rhsTickets.size();
+                if constexpr(kind == join_kind::inner) {
+                    while(lhs < lhs_end && rhs < rhs_end) {
+                        auto const &lhs_ticket= view.lhsTickets[lhs];
+                        auto const &rhs_ticket= view.rhsTickets[rhs];
+                        if(lhs_ticket < rhs_ticket) {
+                            lhs= gallop(view.lhsTickets, lhs, rhs_ticket);
+                        } else if(rhs_ticket < lhs_ticket) {
+                            rhs= gallop(view.rhsTickets, rhs, lhs_ticket);
+                        } else if(
+                            view.lhsOccupancy[lhs] && view.rhsOccupancy[rhs]) {
+                            return;
+                        } else {
+                            ++lhs;
+                            ++rhs;
+                        }
+                    }
+                    lhs= lhs_end;
+                } else {
+                    for(; lhs < lhs_end && !view.lhsOccupancy[lhs]; ++lhs)
+                        ;
+                    if(lhs < lhs_end)
+                        rhs= gallop(
+                            view.rhsTickets, rhs, view.lhsTickets[lhs]);
+                }
+            }
+
+            /// Return the index of the first ticket at or after pos that is not
+            /// less than target, searching forwards in exponentially
+            /// increasing steps and then doing a binary search
+            template <typename TicketView>
+            static std::size_t gallop(
+                TicketView const &tickets, std::size_t pos,
+                ticket_type const &target) noexcept {
+                auto const end= tickets.size();
+                std::size_t low= pos;
+                std::size_t high= pos;
+                std::size_t step= 1;
+                while(high < end && tickets[high] < target) {
+                    low= high + 1;
+                    high+= step;
+                    step*= 2;
+                }
+                high= std::min(high, end);
+                while(low < high) {
+                    auto const mid= low + (high - low) / 2;
+                    if(tickets[mid] < target)
+                        low= mid + 1;
+                    else
+                        high= mid;
+                }
+                return low;
+            }
+
+            /// The view
+            join_view const *join;
+            /// The current left-hand slot
+            std::size_t lhs;
+            /// The current right-hand slot
+            std::size_t rhs;
+        };
+
+        /// Construct a view joining the specified maps
+        join_view(LhsMap &lhs, RhsMap &rhs) noexcept :
+            lhsTickets(lhs.tickets()), lhsOccupancy(lhs.occupancy()),
+            lhsValues(lhs.values()), rhsTickets(rhs.tickets()),
+            rhsOccupancy(rhs.occupancy()), rhsValues(rhs.values()) {}
+
+        /// Returns an iterator to the first element of the view
+        iterator begin() const noexcept {
+            return iterator(this, 0, 0);
+        }
+
+        /// Returns an iterator one-past-the-end of the view
+        iterator end() const noexcept {
+            return iterator(this, lhsTickets.size(), rhsTickets.size());
+        }
+
+    private:
+        lhs_tickets lhsTickets;
+        lhs_occupancy lhsOccupancy;
+        lhs_values lhsValues;
+        rhs_tickets rhsTickets;
+        rhs_occupancy rhsOccupancy;
+        rhs_values rhsValues;
+    };
+
+    /// Return a view of the elements of lhs and rhs that have the same
+    /// tickets, in ticket order. Each element of the view has the ticket, and
+    /// references to the values from lhs and rhs.
+    template <typename LhsMap, typename RhsMap>
+    join_view<LhsMap, RhsMap, join_kind::inner>
+    inner_join(LhsMap &lhs, RhsMap &rhs) noexcept {
+        return {lhs, rhs};
+    }
+
+    /// Return a view of the elements of lhs, in ticket order, along with the
+    /// elements of rhs that have the same tickets. Each element of the view
+    /// has the ticket, a reference to the value from lhs, and a pointer to the
+    /// value from rhs, which is null if rhs has no element with that ticket.
+    template <typename LhsMap, typename RhsMap>
+    join_view<LhsMap, RhsMap, join_kind::left>
+    left_join(LhsMap &lhs, RhsMap &rhs) noexcept {
+        return {lhs, rhs};
+    }
+} // namespace jss
@@ -0,0 +1,234 @@
+// This code is released under the Boost Software License
+// https://www.boost.org/LICENSE_1_0.txt
+// (C) Copyright 2021 Anthony Williams
+
+#pragma once
+
+#include "ticket_map.hpp"
+#include "latency_histogram.hpp"
+#include <cstdlib>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+#include <utility>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define JSS_HAS_RDTSC 1
+#include <intrin.h>
+#elif(defined(__x86_64__) || defined(__i386__)) && \
+    __has_include(<x86intrin.h>)
+#define JSS_HAS_RDTSC 1
+#include <x86intrin.h>
+#else
+#define JSS_HAS_RDTSC 0
+#endif
+
+namespace jss {
+
+    namespace detail {
+        /// The number of kinds of operation that can be timed
+        constexpr std::size_t timed_operation_count= 5;
+
+        /// Read a cheap, monotonic tick counter: the time stamp counter on
+        /// x86, or steady_clock in nanoseconds elsewhere
+        inline std::uint64_t read_ticks() noexcept {
+#if JSS_HAS_RDTSC
+            return __rdtsc();
+#else
+            return static_cast<std::uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch())
+                    .count());
+#endif
+        }
+
+        /// Return the number of ticks per nanosecond. The rate of the time
+        /// stamp counter is measured against steady_clock the first time this
+        /// is called, which takes a few milliseconds.
+        inline double ticks_per_nanosecond() noexcept {
+#if JSS_HAS_RDTSC
+            static double const ratio= [] {
+                using clock= std::chrono::steady_clock;
+                auto const start_time= clock::now();
+                auto const start_ticks= read_ticks();
+                auto now= start_time;
+                while(now - start_time < std::chrono::milliseconds(10)) {
+                    now= clock::now();
+                }
+                auto const ticks= read_ticks() - start_ticks;
+                auto const elapsed=
+                    std::chrono::duration<double, std::nano>(now - start_time)
+                        .count();
+                return std::max(ticks / elapsed, 1e-9);
+            }();
+            return ratio;
+#else
+            return 1.0;
+#endif
+        }
+    } // namespace detail
+
+    /// Latency histograms for each kind of operation on a ticket_map,
+    /// recorded by latency_policy. Latencies are recorded in ticks of the
+    /// time stamp counter where there is one, and reported in nanoseconds.
+    /// To keep the overhead low, only one in every sample_interval operations
+    /// is timed; the others just decrement a counter.
+    class operation_latencies {
+    public:
+        /// Construct with empty histograms, timing one in every
+        /// sample_interval_ operations
+        explicit operation_latencies(
+            std::uint32_t sample_interval_= 1) noexcept :
+            sampleInterval(std::max<std::uint32_t>(sample_interval_, 1)),
+            countdown(1) {}
+
+        /// Returns the name of an operation
+        static char const *name(ticket_map_operation op) noexcept {
+            static char const *const names[detail::timed_operation_count]= {
+                "insert", "erase", "find", "compact", "reserve"};
+            return names[static_cast<std::size_t>(op)];
+        }
+
+        /// Returns the number of operations per sample
+        std::uint32_t sample_interval() const noexcept {
+            return sampleInterval;
+        }
+
+        /// Returns true if the next operation should be timed, false
+        /// otherwise
+        bool sample() noexcept {
+            if(--countdown)
+                return false;
+            countdown= sampleInterval;
+            return true;
+        }
+
+        /// Record the latency of an operation, in ticks
+        void record(ticket_map_operation op, std::uint64_t ticks) noexcept {
+            histograms[static_cast<std::size_t>(op)].record(ticks);
+        }
+
+        /// Returns the histogram for an operation, in ticks
+        latency_histogram const &
+        operator[](ticket_map_operation op) const noexcept {
+            return histograms[static_cast<std::size_t>(op)];
+        }
+
+        /// Returns the number of operations timed
+        std::uint64_t count(ticket_map_operation op) const noexcept {
+            return (*this)[op].count();
+        }
+
+        /// Returns the latency at the specified percentile, from 0 to 100, in
+        /// nanoseconds
+        double percentile(ticket_map_operation op, double p) const noexcept {
+            return (*this)[op].percentile(p) / detail::ticks_per_nanosecond();
+        }
+
+        /// Returns the largest latency recorded, in nanoseconds
+        double max(ticket_map_operation op) const noexcept {
+            return (*this)[op].max() / detail::ticks_per_nanosecond();
+        }
+
+        /// Remove all the recorded latencies
+        void clear() noexcept {
+            for(auto &histogram : histograms) {
+                histogram.clear();
+            }
+        }
+
+        /// Write a table of the percentiles for each operation, in
+        /// nanoseconds, to out
+        void report(std::ostream &out) const {
+            char line[128];
+            std::snprintf(
+                line, sizeof(line), "%-8s %12s %10s %10s %10s %10s %10s\n",
+                "op", "timed", "p50 ns", "p90 ns", "p99 ns", "p99.9 ns",
+                "max ns");
+            out << line;
+            for(std::size_t i= 0; i != detail::timed_operation_count; ++i) {
+                auto const op= static_cast<ticket_map_operation>(i);
+                std::snprintf(
+                    line, sizeof(line),
+                    "%-8s %12llu %10.0f %10.0f %10.0f %10.0f %10.0f\n",
+                    name(op), static_cast<unsigned long long>(count(op)),
+                    percentile(op, 50), percentile(op, 90),
+                    percentile(op, 99), percentile(op, 99.9), max(op));
+                out << line;
+            }
+        }
+
+    private:
+        /// The latencies of each operation
+        std::array<latency_histogram, detail::timed_operation_count>
+            histograms;
+        /// The number of operations per sample
+        std::uint32_t sampleInterval;
+        /// The number of operations until the next sample
+        std::uint32_t countdown;
+    };
+
+    /// A policy that records the latency of operations on the map in an
+    /// operation_latencies object. Compaction and growth are timed both on
+    /// their own and as part of the operation that triggered them, so the
+    /// spikes they cause show up in the tail of that operation's histogram.
+    /// A default-constructed policy records nothing.
+    template <typename Base= default_ticket_map_policy>
+    struct latency_policy : Base {
+        /// Times one operation, from construction to destruction, and
+        /// records it if it was sampled
+        class timer {
+        public:
+            /// Start timing op, and start the base policy's timer
+            timer(
+                latency_policy const &policy,
+                ticket_map_operation op_) noexcept :
+                baseTimer(policy.Base::start_timer(op_)),
+                latencies(
+                    policy.latencies && policy.latencies->sample() ?
+                        policy.latencies :
+                        nullptr),
+                op(op_), start(latencies ? detail::read_ticks() : 0) {}
+
+            timer(timer const &)= delete;
+            timer &operator=(timer const &)= delete;
+
+            /// Record the time taken, if the operation was sampled
+            ~timer() {
+                if(latencies)
+                    latencies->record(op, detail::read_ticks() - start);
+            }
+
+        private:
+            /// The base policy's timer
+            decltype(std::declval<Base const &>().start_timer(
+                ticket_map_operation::insert)) baseTimer;
+            /// Where to record the time, or nullptr if not sampled
+            operation_latencies *latencies;
+            /// The operation being timed
+            ticket_map_operation op;
+            /// The tick count at the start of the operation
+            std::uint64_t start;
+        };
+
+        /// Construct a policy that records nothing
+        latency_policy()= default;
+
+        /// Construct a policy that records latencies in latencies_
+        explicit latency_policy(
+            operation_latencies &latencies_, Base base= Base()) :
+            Base(std::move(base)),
+            latencies(&latencies_) {}
+
+        /// Start timing an operation
+        timer start_timer(ticket_map_operation op) const noexcept {
+            return timer(*this, op);
+        }
+
+        /// Where to record latencies, if anywhere
+        operation_latencies *latencies= nullptr;
+    };
+} // namespace jss
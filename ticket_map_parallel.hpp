@@ -0,0 +1,179 @@
+// This code is released under the Boost Software License
+// https://www.boost.org/LICENSE_1_0.txt
+// (C) Copyright 2021 Anthony Williams
+
+#pragma once
+
+#include "ticket_map.hpp"
+#include <cstdlib>
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace jss {
+
+    namespace detail {
+        /// Counts down the chunks of a parallel_for, recording the first
+        /// exception thrown by any of them
+        class chunk_latch {
+        public:
+            explicit chunk_latch(std::size_t count) noexcept :
+                remaining(count) {}
+
+            /// Mark a chunk as done. error is the exception it threw, if any.
+            void count_down(std::exception_ptr error) noexcept {
+                std::lock_guard<std::mutex> guard(mutex);
+                if(error && !firstError)
+                    firstError= error;
+                if(!--remaining)
+                    done.notify_all();
+            }
+
+            /// Wait for all the chunks to be done, and rethrow the first
+            /// exception, if any
+            void wait() {
+                std::unique_lock<std::mutex> lock(mutex);
+                done.wait(lock, [this] { return remaining == 0; });
+                if(firstError)
+                    std::rethrow_exception(firstError);
+            }
+
+        private:
+            std::mutex mutex;
+            std::condition_variable done;
+            std::size_t remaining;
+            std::exception_ptr firstError;
+        };
+
+        /// Call f(first,last) for each of chunks consecutive chunks of
+        /// [0,count), and wait for them all to finish. The first chunk is
+        /// run on the calling thread, and the rest are passed to executor as
+        /// nullary callables. If executor throws when given a chunk, that
+        /// chunk is run on the calling thread instead, so executor must only
+        /// throw if it has not taken ownership of the callable; a callable
+        /// that is run after executor has thrown would run its chunk twice.
+        /// Rethrows the first exception thrown by f, once all the chunks are
+        /// done.
+        template <typename Executor, typename F>
+        void parallel_for(
+            Executor &executor, std::size_t count, std::size_t chunks,
+            F const &f) {
+            chunks= std::max<std::size_t>(std::min(chunks, count), 1);
+            chunk_latch latch(chunks);
+            auto run_chunk= [&](std::size_t chunk) noexcept {
+                std::exception_ptr error;
+                try {
+                    f(count * chunk / chunks, count * (chunk + 1) / chunks);
+                } catch(...) {
+                    error= std::current_exception();
+                }
+                latch.count_down(error);
+            };
+            for(std::size_t chunk= 1; chunk < chunks; ++chunk) {
+                try {
+                    executor([&run_chunk, chunk] { run_chunk(chunk); });
+                } catch(...) {
+                    run_chunk(chunk);
+                }
+            }
+            run_chunk(0);
+            latch.wait();
+        }
+
+        /// The default number of chunks to split parallel work into
+        inline std::size_t default_chunk_count() noexcept {
+            return std::max(std::thread::hardware_concurrency(), 1u);
+        }
+
+        /// Implements the parallel operations on the storage of a ticket_map
+        struct ticket_map_parallel_access {
+            /// The smallest number of slots worth handing to another thread
+            static constexpr std::size_t min_parallel_chunk= 4096;
+
+            /// The number of chunks to split the storage of map into for
+            /// parallel work, given the number requested
+            template <typename Map>
+            static std::size_t
+            chunk_count(Map const &map, std::size_t requested) noexcept {
+                return std::min(
+                    requested, map.data.size() / min_parallel_chunk + 1);
+            }
+
+            /// Implements parallel_clone
+            template <typename Map, typename Executor>
+            static Map
+            clone(Map const &map, Executor &executor, std::size_t chunks) {
+                Map result(map.mapPolicy);
+                result.data.resize(map.data.size());
+                parallel_for(
+                    executor, map.data.size(), chunk_count(map, chunks),
+                    [&](std::size_t first, std::size_t last) {
+                        for(auto i= first; i != last; ++i) {
+                            result.data[i].first= map.data[i].first;
+                            if(map.data[i].second)
+                                result.data[i].second.emplace(
+                                    *map.data[i].second);
+                        }
+                    });
+                result.overflow= map.overflow;
+                result.nextId= map.nextId;
+                result.filledItems= map.filledItems;
+                result.reservations= map.reservations;
+                result.orderStatistics= map.orderStatistics;
+                result.trackOrderStatistics= map.trackOrderStatistics;
+                result.storage_changed();
+                return result;
+            }
+
+            /// Implements parallel_teardown
+            template <typename Map, typename Executor>
+            static void
+            teardown(Map &map, Executor &executor, std::size_t chunks) {
+                parallel_for(
+                    executor, map.data.size(), chunk_count(map, chunks),
+                    [&](std::size_t first, std::size_t last) {
+                        for(auto i= first; i != last; ++i) {
+                            map.data[i].second.reset();
+                        }
+                    });
+                typename Map::collection_type().swap(map.data);
+                map.filledItems= 0;
+                map.reservations.clear();
+                std::vector<std::size_t>().swap(map.orderStatistics);
+                map.storage_changed();
+            }
+        };
+    } // namespace detail
+
+    /// Return a copy of map, copying the storage in chunks concurrently. All
+    /// but one of the chunks are passed to executor as nullary callables,
+    /// which it must run, on other threads if the copy is to be done in
+    /// parallel. If executor throws, it must not also run the callable it was
+    /// given; that chunk is copied on the calling thread instead. The copy has
+    /// the same elements, next ticket value and reservations as map.
+    /// Rethrows any exception thrown when copying a value, once all the
+    /// chunks are done.
+    template <
+        typename Ticket, typename Value, typename Policy, typename Executor>
+    ticket_map<Ticket, Value, Policy> parallel_clone(
+        ticket_map<Ticket, Value, Policy> const &map, Executor &&executor,
+        std::size_t chunks= detail::default_chunk_count()) {
+        return detail::ticket_map_parallel_access::clone(map, executor, chunks);
+    }
+
+    /// Destroy all the elements of map, in chunks concurrently, and release
+    /// the storage. All but one of the chunks are passed to executor as
+    /// nullary callables, as for parallel_clone(). The map is left empty, with
+    /// all reservations cancelled, and subsequently issued tickets follow on
+    /// from those issued before.
+    template <
+        typename Ticket, typename Value, typename Policy, typename Executor>
+    void parallel_teardown(
+        ticket_map<Ticket, Value, Policy> &map, Executor &&executor,
+        std::size_t chunks= detail::default_chunk_count()) {
+        detail::ticket_map_parallel_access::teardown(map, executor, chunks);
+    }
+} // namespace jss
@@ -0,0 +1,104 @@
+// This code is released under the Boost Software License
+// https://www.boost.org/LICENSE_1_0.txt
+// (C) Copyright 2021 Anthony Williams
+
+#pragma once
+
+#include <cstdint>
+
+/// Static tracepoints for ticket_map's slow paths, as Linux USDT probes in
+/// the jss_ticket_map provider. The probes use the SystemTap SDT format, so
+/// perf, bpftrace and systemtap can attach to them in an unmodified binary,
+/// and cost a single nop when nothing is attached. There is no runtime
+/// dependency: <sys/sdt.h> is used if it is available, and otherwise the
+/// probe notes are emitted directly on x86-64 ELF platforms with GCC or
+/// Clang. On other platforms, or if JSS_TICKET_MAP_DISABLE_PROBES is
+/// defined, the probes expand to nothing.
+///
+/// Every argument is passed as a 64-bit unsigned integer. The probes are:
+///   compact_start(slots, holes)         compact_end(slots, moved)
+///   reallocate_start(slots, holes, capacity)
+///                                       reallocate_end(slots, capacity)
+///   batch_start(size, pending)          batch_end(size)
+///   bulk_load_start(size, loaded)       bulk_load_end(size)
+///   overflow(size)
+/// where slots is the number of slots in the storage, holes the number of
+/// those that are empty, moved the number of entries moved, and capacity the
+/// capacity reallocated to or from.
+#if defined(JSS_TICKET_MAP_DISABLE_PROBES)
+#define JSS_HAS_USDT_PROBES 0
+#elif __has_include(<sys/sdt.h>)
+#define JSS_HAS_USDT_PROBES 1
+#include <sys/sdt.h>
+#elif defined(__ELF__) && defined(__x86_64__) && defined(__GNUC__)
+#define JSS_HAS_USDT_PROBES 1
+#define JSS_USDT_NOTES 1
+#else
+#define JSS_HAS_USDT_PROBES 0
+#endif
+
+#if JSS_HAS_USDT_PROBES && !defined(JSS_USDT_NOTES)
+
+#define JSS_TICKET_MAP_PROBE1(name, a1)                                       \
+    STAP_PROBE1(jss_ticket_map, name, static_cast<std::uint64_t>(a1))
+#define JSS_TICKET_MAP_PROBE2(name, a1, a2)                                   \
+    STAP_PROBE2(                                                              \
+        jss_ticket_map, name, static_cast<std::uint64_t>(a1),                 \
+        static_cast<std::uint64_t>(a2))
+#define JSS_TICKET_MAP_PROBE3(name, a1, a2, a3)                               \
+    STAP_PROBE3(                                                              \
+        jss_ticket_map, name, static_cast<std::uint64_t>(a1),                 \
+        static_cast<std::uint64_t>(a2), static_cast<std::uint64_t>(a3))
+
+#elif JSS_HAS_USDT_PROBES
+
+/// The assembly for a probe: a nop at the probe site, a .note.stapsdt entry
+/// describing it, and the .stapsdt.base section the tools use to adjust the
+/// recorded address if the binary is prelinked
+#define JSS_USDT_ASM(name, args)                                              \
+    "990: nop\n"                                                              \
+    ".pushsection .note.stapsdt,\"?\",\"note\"\n"                             \
+    ".balign 4\n"                                                             \
+    ".4byte 992f-991f, 994f-993f, 3\n"                                        \
+    "991: .asciz \"stapsdt\"\n"                                               \
+    "992: .balign 4\n"                                                        \
+    "993: .8byte 990b\n"                                                      \
+    ".8byte _.stapsdt.base\n"                                                 \
+    ".8byte 0\n"                                                              \
+    ".asciz \"jss_ticket_map\"\n"                                             \
+    ".asciz \"" #name "\"\n"                                                  \
+    ".asciz \"" args "\"\n"                                                   \
+    "994: .balign 4\n"                                                        \
+    ".popsection\n"                                                           \
+    ".ifndef _.stapsdt.base\n"                                                \
+    ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n"   \
+    ".weak _.stapsdt.base\n"                                                  \
+    ".hidden _.stapsdt.base\n"                                                \
+    "_.stapsdt.base: .space 1\n"                                              \
+    ".size _.stapsdt.base, 1\n"                                               \
+    ".popsection\n"                                                           \
+    ".endif\n"
+
+#define JSS_TICKET_MAP_PROBE1(name, a1)                                       \
+    __asm__ __volatile__(JSS_USDT_ASM(name, "8@%[arg1]")                      \
+                         :                                                    \
+                         : [arg1] "nor"(static_cast<std::uint64_t>(a1)))
+#define JSS_TICKET_MAP_PROBE2(name, a1, a2)                                   \
+    __asm__ __volatile__(JSS_USDT_ASM(name, "8@%[arg1] 8@%[arg2]")            \
+                         :                                                    \
+                         : [arg1] "nor"(static_cast<std::uint64_t>(a1)),      \
+                           [arg2] "nor"(static_cast<std::uint64_t>(a2)))
+#define JSS_TICKET_MAP_PROBE3(name, a1, a2, a3)                               \
+    __asm__ __volatile__(JSS_USDT_ASM(name, "8@%[arg1] 8@%[arg2] 8@%[arg3]")  \
+                         :                                                    \
+                         : [arg1] "nor"(static_cast<std::uint64_t>(a1)),      \
+                           [arg2] "nor"(static_cast<std::uint64_t>(a2)),      \
+                           [arg3] "nor"(static_cast<std::uint64_t>(a3)))
+
+#else
+
+#define JSS_TICKET_MAP_PROBE1(name, a1) ((void)0)
+#define JSS_TICKET_MAP_PROBE2(name, a1, a2) ((void)0)
+#define JSS_TICKET_MAP_PROBE3(name, a1, a2, a3) ((void)0)
+
+#endif
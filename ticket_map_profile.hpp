@@ -0,0 +1,321 @@
+// This code is released under the Boost Software License
+// https://www.boost.org/LICENSE_1_0.txt
+// (C) Copyright 2021 Anthony Williams
+
+#pragma once
+
+#include "ticket_map.hpp"
+#include "latency_histogram.hpp"
+#include <cstdlib>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+#include <ostream>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace jss {
+
+    /// The lifetimes of the elements of a ticket_map, and how much of the
+    /// work of compaction goes into moving long-lived stragglers, as gathered
+    /// by profiling_policy.
+    ///
+    /// Ages are measured when an element is erased, both in tickets issued
+    /// since its own and in wall time. To avoid timestamping every element,
+    /// the time is recorded for one in every checkpoint_interval inserts, so
+    /// the age in wall time is measured from the last checkpoint at or before
+    /// the element's ticket. An element moved by compaction counts as a
+    /// straggler if more than straggler_age tickets have been issued since
+    /// its own.
+    class lifetime_profile {
+    public:
+        /// Construct an empty profile
+        explicit lifetime_profile(
+            std::uint64_t straggler_age_= 65536,
+            std::uint64_t checkpoint_interval_= 64) noexcept :
+            stragglerAge(straggler_age_),
+            checkpointInterval(
+                std::max<std::uint64_t>(checkpoint_interval_, 1)),
+            start(clock::now()) {}
+
+        /// Record the insertion of the element with the specified ticket
+        void inserted(std::uint64_t ticket) noexcept {
+            latest= std::max(latest, ticket);
+            if(inserts++ % checkpointInterval)
+                return;
+            try {
+                checkpoints.emplace_back(ticket, now());
+            } catch(...) {
+            }
+        }
+
+        /// Record the erasure of the element with the specified ticket
+        void erased(std::uint64_t ticket) noexcept {
+            ageInTickets.record(ticket_age(ticket));
+            auto const checkpoint= std::upper_bound(
+                checkpoints.begin(), checkpoints.end(), ticket,
+                [](std::uint64_t ticket, auto const &checkpoint) {
+                    return ticket < checkpoint.first;
+                });
+            if(checkpoint != checkpoints.begin())
+                ageInTime.record(now() - std::prev(checkpoint)->second);
+        }
+
+        /// Record that compaction moved the element with the specified ticket
+        void moved(std::uint64_t ticket) noexcept {
+            ++moves;
+            if(ticket_age(ticket) > stragglerAge)
+                ++stragglerMoves;
+        }
+
+        /// Returns the ages of erased elements, in tickets issued since
+        latency_histogram const &age_in_tickets() const noexcept {
+            return ageInTickets;
+        }
+
+        /// Returns the ages of erased elements, in nanoseconds
+        latency_histogram const &age_in_nanoseconds() const noexcept {
+            return ageInTime;
+        }
+
+        /// Returns the number of elements moved by compaction
+        std::uint64_t compaction_moves() const noexcept {
+            return moves;
+        }
+
+        /// Returns the number of stragglers moved by compaction
+        std::uint64_t straggler_moves() const noexcept {
+            return stragglerMoves;
+        }
+
+        /// Returns the fraction of the elements moved by compaction that were
+        /// stragglers, or 0 if there have been no moves
+        double straggler_fraction() const noexcept {
+            return moves ? static_cast<double>(stragglerMoves) / moves : 0.0;
+        }
+
+        /// Write a summary of the profile to out
+        void report(std::ostream &out) const {
+            char line[128];
+            std::snprintf(
+                line, sizeof(line), "%-16s %12s %12s %12s %12s %12s\n",
+                "age at erase", "count", "p50", "p90", "p99", "max");
+            out << line;
+            write_ages(out, "tickets", ageInTickets);
+            write_ages(out, "ns", ageInTime);
+            std::snprintf(
+                line, sizeof(line),
+                "compaction moves %llu, of which stragglers (age > %llu) "
+                "%llu (%.1f%%)\n",
+                static_cast<unsigned long long>(moves),
+                static_cast<unsigned long long>(stragglerAge),
+                static_cast<unsigned long long>(stragglerMoves),
+                straggler_fraction() * 100);
+            out << line;
+        }
+
+    private:
+        using clock= std::chrono::steady_clock;
+
+        /// Returns the time since the profile started, in nanoseconds
+        std::uint64_t now() const noexcept {
+            return static_cast<std::uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    clock::now() - start)
+                    .count());
+        }
+
+        /// Returns the number of tickets issued since the specified ticket
+        std::uint64_t ticket_age(std::uint64_t ticket) const noexcept {
+            return latest > ticket ? latest - ticket : 0;
+        }
+
+        /// Write one line of the age table
+        static void write_ages(
+            std::ostream &out, char const *unit,
+            latency_histogram const &ages) {
+            char line[128];
+            std::snprintf(
+                line, sizeof(line),
+                "%-16s %12llu %12llu %12llu %12llu %12llu\n", unit,
+                static_cast<unsigned long long>(ages.count()),
+                static_cast<unsigned long long>(ages.percentile(50)),
+                static_cast<unsigned long long>(ages.percentile(90)),
+                static_cast<unsigned long long>(ages.percentile(99)),
+                static_cast<unsigned long long>(ages.max()));
+            out << line;
+        }
+
+        /// The age above which a moved element is a straggler
+        std::uint64_t stragglerAge;
+        /// The number of inserts per checkpoint
+        std::uint64_t checkpointInterval;
+        /// The time the profile started
+        clock::time_point start;
+        /// The number of inserts so far
+        std::uint64_t inserts= 0;
+        /// The largest ticket inserted so far
+        std::uint64_t latest= 0;
+        /// The times of some inserts, in ticket order
+        std::vector<std::pair<std::uint64_t, std::uint64_t>> checkpoints;
+        /// The ages of erased elements in tickets
+        latency_histogram ageInTickets;
+        /// The ages of erased elements in nanoseconds
+        latency_histogram ageInTime;
+        /// The number of elements moved by compaction
+        std::uint64_t moves= 0;
+        /// The number of stragglers moved by compaction
+        std::uint64_t stragglerMoves= 0;
+    };
+
+    /// A policy that records the lifetimes of the elements in the map, and
+    /// the elements moved by compaction, in a lifetime_profile. Ticket must be
+    /// an integral type. A default-constructed policy records nothing.
+    template <typename Base= default_ticket_map_policy>
+    struct profiling_policy : Base {
+        /// Construct a policy that records nothing
+        profiling_policy()= default;
+
+        /// Construct a policy that records in profile_
+        explicit profiling_policy(
+            lifetime_profile &profile_, Base base= Base()) :
+            Base(std::move(base)), profile(&profile_) {}
+
+        /// Record inserts and erasures, and pass the operation on to the base
+        /// policy
+        template <typename Ticket>
+        void
+        on_operation(ticket_map_operation op, Ticket const &ticket) const
+            noexcept {
+            static_assert(
+                std::is_integral_v<Ticket>,
+                "Only integral tickets can be profiled");
+            if(profile) {
+                if(op == ticket_map_operation::insert)
+                    profile->inserted(static_cast<std::uint64_t>(ticket));
+                else if(op == ticket_map_operation::erase)
+                    profile->erased(static_cast<std::uint64_t>(ticket));
+            }
+            Base::on_operation(op, ticket);
+        }
+
+        /// Record the move, and pass it on to the base policy
+        template <typename Ticket>
+        void on_compaction_move(Ticket const &ticket) const noexcept {
+            if(profile)
+                profile->moved(static_cast<std::uint64_t>(ticket));
+            Base::on_compaction_move(ticket);
+        }
+
+        /// The profile to record in, if any
+        lifetime_profile *profile= nullptr;
+    };
+
+    /// How the empty slots in a ticket_map's storage are spread across the
+    /// pages of memory it occupies, as returned by profile_fragmentation().
+    /// Reserved slots count as empty.
+    struct fragmentation_profile {
+        /// The size of a page
+        static constexpr std::size_t page_size= 4096;
+
+        /// The number of slots in each page the storage touches, in address
+        /// order
+        std::vector<std::size_t> slots_per_page;
+        /// The number of empty slots in each page the storage touches
+        std::vector<std::size_t> holes_per_page;
+        /// The total number of slots
+        std::size_t slots= 0;
+        /// The total number of empty slots
+        std::size_t holes= 0;
+
+        /// Returns the number of pages whose fraction of empty slots falls in
+        /// each tenth from 0 to 1, with pages that are entirely empty in the
+        /// last entry
+        std::array<std::size_t, 11> pages_by_hole_fraction() const {
+            std::array<std::size_t, 11> pages{};
+            for(std::size_t i= 0; i != slots_per_page.size(); ++i) {
+                ++pages[holes_per_page[i] * 10 / slots_per_page[i]];
+            }
+            return pages;
+        }
+
+        /// Returns the fraction of empty slots in each of parts equal ranges
+        /// of pages, from the start of the storage, which holds the oldest
+        /// tickets, to the end
+        std::vector<double> hole_fraction_by_position(std::size_t parts) const {
+            std::vector<double> fractions;
+            auto const pages= slots_per_page.size();
+            for(std::size_t part= 0; part != parts; ++part) {
+                std::size_t part_slots= 0;
+                std::size_t part_holes= 0;
+                for(auto page= pages * part / parts;
+                    page != pages * (part + 1) / parts; ++page) {
+                    part_slots+= slots_per_page[page];
+                    part_holes+= holes_per_page[page];
+                }
+                fractions.push_back(
+                    part_slots ? static_cast<double>(part_holes) / part_slots :
+                                 0.0);
+            }
+            return fractions;
+        }
+
+        /// Write a summary of the profile to out
+        void report(std::ostream &out) const {
+            char line[128];
+            std::snprintf(
+                line, sizeof(line),
+                "%zu slots in %zu pages, %zu empty (%.1f%%)\n", slots,
+                slots_per_page.size(), holes,
+                slots ? holes * 100.0 / slots : 0.0);
+            out << line;
+            auto const pages= pages_by_hole_fraction();
+            out << "pages by empty fraction:";
+            for(std::size_t i= 0; i != pages.size(); ++i) {
+                if(i < 10)
+                    std::snprintf(
+                        line, sizeof(line), " <%zu%%:%zu", (i + 1) * 10,
+                        pages[i]);
+                else
+                    std::snprintf(line, sizeof(line), " 100%%:%zu", pages[i]);
+                out << line;
+            }
+            out << "\nempty fraction by position, oldest first:";
+            for(auto fraction : hole_fraction_by_position(10)) {
+                std::snprintf(line, sizeof(line), " %.0f%%", fraction * 100);
+                out << line;
+            }
+            out << "\n";
+        }
+    };
+
+    /// Return how the empty slots in map's storage are spread across the
+    /// pages of memory it occupies
+    template <typename Map>
+    fragmentation_profile profile_fragmentation(Map const &map) {
+        fragmentation_profile profile;
+        auto const tickets= map.tickets();
+        auto const occupancy= map.occupancy();
+        std::uintptr_t current_page= 0;
+        for(std::size_t i= 0; i != tickets.size(); ++i) {
+            auto const page= reinterpret_cast<std::uintptr_t>(&tickets[i]) /
+                             fragmentation_profile::page_size;
+            if(profile.slots_per_page.empty() || page != current_page) {
+                current_page= page;
+                profile.slots_per_page.push_back(0);
+                profile.holes_per_page.push_back(0);
+            }
+            ++profile.slots_per_page.back();
+            if(!occupancy[i]) {
+                ++profile.holes_per_page.back();
+                ++profile.holes;
+            }
+        }
+        profile.slots= tickets.size();
+        return profile;
+    }
+} // namespace jss
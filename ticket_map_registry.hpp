@@ -0,0 +1,291 @@
+// This code is released under the Boost Software License
+// https://www.boost.org/LICENSE_1_0.txt
+// (C) Copyright 2021 Anthony Williams
+
+#pragma once
+
+#include "ticket_map.hpp"
+#include <cstdlib>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <ostream>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+namespace jss {
+
+    /// A registry of ticket_map instances that use registry_policy, which a
+    /// diagnostics thread can snapshot at any time to find out which maps are
+    /// using the most memory. Registrations are kept in a lock-free list.
+    /// Entries are never removed from the list; the entry for a destroyed map
+    /// is marked free, and reused by the next map to register. So taking a
+    /// snapshot never blocks the maps, and registering only allocates when
+    /// there are no free entries.
+    class ticket_map_registry {
+        /// The states of a registration
+        enum state { free_state, claimed_state, live_state };
+
+    public:
+        /// A snapshot of the statistics for one registered map
+        struct entry {
+            /// The name the map was registered with
+            char const *name;
+            /// The name of the map's type, as given by std::type_info::name
+            char const *type;
+            /// The number of elements
+            std::size_t size;
+            /// The number of slots in the storage, including empty ones
+            std::size_t slots;
+            /// The capacity of the storage, in slots
+            std::size_t capacity;
+            /// The memory used by the map, in bytes
+            std::size_t bytes;
+
+            /// Returns the fraction of the slots that are empty
+            double hole_ratio() const noexcept {
+                return slots ? static_cast<double>(slots - size) / slots : 0.0;
+            }
+        };
+
+        /// The registration of one map, holding its latest statistics
+        class registration {
+        public:
+            /// Update the statistics for the map
+            void update(
+                char const *type_, std::size_t size_, std::size_t slots_,
+                std::size_t capacity_, std::size_t bytes_) noexcept {
+                type.store(type_, std::memory_order_relaxed);
+                size.store(size_, std::memory_order_relaxed);
+                slots.store(slots_, std::memory_order_relaxed);
+                capacity.store(capacity_, std::memory_order_relaxed);
+                bytes.store(bytes_, std::memory_order_relaxed);
+            }
+
+            /// Returns the name the map was registered with
+            char const *name() const noexcept {
+                return mapName.load(std::memory_order_relaxed);
+            }
+
+        private:
+            friend class ticket_map_registry;
+
+            /// Set the name, and clear the statistics
+            void reset(char const *name_) noexcept {
+                mapName.store(name_, std::memory_order_relaxed);
+                update("", 0, 0, 0, 0);
+            }
+
+            /// Whether the registration is in use
+            std::atomic<int> status{free_state};
+            /// The next registration in the list
+            registration *next= nullptr;
+            /// The name of the map
+            std::atomic<char const *> mapName{""};
+            /// The name of the map's type
+            std::atomic<char const *> type{""};
+            /// The number of elements
+            std::atomic<std::size_t> size{0};
+            /// The number of slots in the storage
+            std::atomic<std::size_t> slots{0};
+            /// The capacity of the storage
+            std::atomic<std::size_t> capacity{0};
+            /// The memory used, in bytes
+            std::atomic<std::size_t> bytes{0};
+        };
+
+        /// Construct an empty registry
+        ticket_map_registry() noexcept= default;
+
+        ticket_map_registry(ticket_map_registry const &)= delete;
+        ticket_map_registry &operator=(ticket_map_registry const &)= delete;
+
+        /// Destroy the registry. No maps may still be registered with it.
+        ~ticket_map_registry() {
+            auto node= head.load(std::memory_order_acquire);
+            while(node) {
+                delete std::exchange(node, node->next);
+            }
+        }
+
+        /// Returns the registry used by registry_policy by default
+        static ticket_map_registry &global() {
+            static ticket_map_registry registry;
+            return registry;
+        }
+
+        /// Register a map with the specified name, which must remain valid
+        /// until the registration is released. Reuses a free entry if there
+        /// is one. Throws bad_alloc if there is none and a new one can't be
+        /// allocated.
+        registration *acquire(char const *name) {
+            for(auto node= head.load(std::memory_order_acquire); node;
+                node= node->next) {
+                int expected= free_state;
+                if(node->status.compare_exchange_strong(
+                       expected, claimed_state, std::memory_order_acquire,
+                       std::memory_order_relaxed)) {
+                    node->reset(name);
+                    node->status.store(live_state, std::memory_order_release);
+                    return node;
+                }
+            }
+            auto node= new registration;
+            node->reset(name);
+            node->status.store(live_state, std::memory_order_relaxed);
+            node->next= head.load(std::memory_order_relaxed);
+            while(!head.compare_exchange_weak(
+                node->next, node, std::memory_order_release,
+                std::memory_order_relaxed))
+                ;
+            return node;
+        }
+
+        /// Release a registration, so its entry can be reused
+        void release(registration *node) noexcept {
+            node->status.store(free_state, std::memory_order_release);
+        }
+
+        /// Returns the statistics for every registered map. The statistics
+        /// for each map are as of the last change to its storage, and may be
+        /// inconsistent with each other if the storage is changing while the
+        /// snapshot is taken.
+        std::vector<entry> snapshot() const {
+            std::vector<entry> entries;
+            for(auto node= head.load(std::memory_order_acquire); node;
+                node= node->next) {
+                if(node->status.load(std::memory_order_acquire) != live_state)
+                    continue;
+                entries.push_back(
+                    {node->mapName.load(std::memory_order_relaxed),
+                     node->type.load(std::memory_order_relaxed),
+                     node->size.load(std::memory_order_relaxed),
+                     node->slots.load(std::memory_order_relaxed),
+                     node->capacity.load(std::memory_order_relaxed),
+                     node->bytes.load(std::memory_order_relaxed)});
+            }
+            return entries;
+        }
+
+        /// Write a table of the registered maps to out, largest first, with
+        /// the totals
+        void report(std::ostream &out) const {
+            auto entries= snapshot();
+            std::sort(
+                entries.begin(), entries.end(),
+                [](entry const &lhs, entry const &rhs) {
+                    return lhs.bytes > rhs.bytes;
+                });
+            char line[256];
+            std::snprintf(
+                line, sizeof(line), "%-24s %12s %12s %12s %8s %14s  %s\n",
+                "name", "size", "slots", "capacity", "holes", "bytes", "type");
+            out << line;
+            entry total{"total", "", 0, 0, 0, 0};
+            for(auto const &map : entries) {
+                write_entry(out, map);
+                total.size+= map.size;
+                total.slots+= map.slots;
+                total.capacity+= map.capacity;
+                total.bytes+= map.bytes;
+            }
+            write_entry(out, total);
+        }
+
+    private:
+        /// Write one line of the report
+        static void write_entry(std::ostream &out, entry const &map) {
+            char line[256];
+            std::snprintf(
+                line, sizeof(line),
+                "%-24.24s %12zu %12zu %12zu %7.1f%% %14zu  %.120s\n", map.name,
+                map.size, map.slots, map.capacity, map.hole_ratio() * 100,
+                map.bytes, map.type);
+            out << line;
+        }
+
+        /// The first registration in the list
+        std::atomic<registration *> head{nullptr};
+    };
+
+    /// A policy that registers the map with a ticket_map_registry under a
+    /// name, and updates its statistics whenever the map's storage changes,
+    /// so inserts, erasures and lookups cost nothing extra. A copy of the map
+    /// is registered separately under the same name; a moved-to map takes
+    /// over the registration. A default-constructed policy registers with
+    /// the global registry with an empty name.
+    template <typename Base= default_ticket_map_policy>
+    struct registry_policy : Base {
+        /// Register with the global registry with an empty name
+        registry_policy() : registry_policy("") {}
+
+        /// Register with registry_ under name_, which must remain valid for
+        /// the lifetime of the map, such as a string literal
+        explicit registry_policy(
+            char const *name_,
+            ticket_map_registry &registry_= ticket_map_registry::global(),
+            Base base= Base()) :
+            Base(std::move(base)),
+            registry(&registry_), registered(registry_.acquire(name_)) {}
+
+        /// Register a copy under the same name
+        registry_policy(registry_policy const &other) :
+            Base(other), registry(other.registry),
+            registered(
+                other.registry ?
+                    other.registry->acquire(other.registered_name()) :
+                    nullptr) {}
+
+        /// Take over the registration from other
+        registry_policy(registry_policy &&other) noexcept :
+            Base(std::move(other)), registry(other.registry),
+            registered(std::exchange(other.registered, nullptr)) {}
+
+        /// Copy the base policy; the registration is unchanged
+        registry_policy &operator=(registry_policy const &other) {
+            Base::operator=(other);
+            return *this;
+        }
+
+        /// Release the registration, and take over the registration from
+        /// other
+        registry_policy &operator=(registry_policy &&other) noexcept {
+            Base::operator=(std::move(other));
+            if(registered)
+                registry->release(registered);
+            registry= other.registry;
+            registered= std::exchange(other.registered, nullptr);
+            return *this;
+        }
+
+        /// Release the registration
+        ~registry_policy() {
+            if(registered)
+                registry->release(registered);
+        }
+
+        /// Update the statistics for the map, and pass the change on to the
+        /// base policy
+        template <typename Map>
+        void on_storage_changed(Map const &map) const noexcept {
+            if(registered)
+                registered->update(
+                    typeid(Map).name(), map.size(), map.tickets().size(),
+                    map.capacity(), map.memory_usage());
+            Base::on_storage_changed(map);
+        }
+
+        /// Returns the name the map is registered under, or an empty string
+        /// if it is not registered
+        char const *registered_name() const noexcept {
+            return registered ? registered->name() : "";
+        }
+
+    private:
+        /// The registry
+        ticket_map_registry *registry;
+        /// The map's registration, if any
+        ticket_map_registry::registration *registered;
+    };
+} // namespace jss
@@ -0,0 +1,230 @@
+// This code is released under the Boost Software License
+// https://www.boost.org/LICENSE_1_0.txt
+// (C) Copyright 2021 Anthony Williams
+
+#pragma once
+
+#include "ticket_map.hpp"
+#include <cstdlib>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace jss {
+
+    /// Tracks the most frequently looked-up tickets of a ticket_map with the
+    /// space-saving heavy hitters algorithm, fed by access_sketch_policy.
+    /// capacity counters are kept; a ticket that is not being counted takes
+    /// over the counter with the smallest count, inheriting that count as its
+    /// possible error, so any ticket looked up more often than 1/capacity of
+    /// the time is guaranteed to be counted.
+    ///
+    /// To keep the overhead of lookups low, only one in every sample_interval
+    /// lookups is counted, and the counters are only scanned for sampled
+    /// lookups. Lookups may be made from several threads at once, as for a
+    /// const map; if two threads sample at the same time, one of the samples
+    /// is dropped rather than waiting.
+    class access_sketch {
+    public:
+        /// The count for one ticket
+        struct hot_ticket {
+            /// The ticket
+            std::uint64_t ticket;
+            /// The estimated number of sampled lookups of the ticket
+            std::uint64_t count;
+            /// The amount by which count may overestimate the true number
+            std::uint64_t error;
+        };
+
+        /// Construct a sketch with capacity_ counters, sampling one in every
+        /// sample_interval_ lookups
+        explicit access_sketch(
+            std::size_t capacity_= 32, std::uint32_t sample_interval_= 16) :
+            capacity(std::max<std::size_t>(capacity_, 1)),
+            sampleInterval(std::max<std::uint32_t>(sample_interval_, 1)),
+            countdown(1) {
+            counters.reserve(capacity);
+        }
+
+        access_sketch(access_sketch const &)= delete;
+        access_sketch &operator=(access_sketch const &)= delete;
+
+        /// Record a lookup of ticket, if it is sampled
+        void record(std::uint64_t ticket) noexcept {
+            auto const remaining= countdown.load(std::memory_order_relaxed);
+            if(remaining > 1) {
+                countdown.store(remaining - 1, std::memory_order_relaxed);
+                return;
+            }
+            countdown.store(sampleInterval, std::memory_order_relaxed);
+            if(busy.test_and_set(std::memory_order_acquire))
+                return;
+            count(ticket);
+            busy.clear(std::memory_order_release);
+        }
+
+        /// Returns the number of lookups per sample
+        std::uint32_t sample_interval() const noexcept {
+            return sampleInterval;
+        }
+
+        /// Returns the number of sampled lookups counted
+        std::uint64_t samples() const noexcept {
+            lock_guard guard(busy);
+            return total;
+        }
+
+        /// Returns up to k of the most frequently looked-up tickets, most
+        /// frequent first
+        std::vector<hot_ticket> top(std::size_t k) const {
+            std::vector<hot_ticket> result;
+            {
+                lock_guard guard(busy);
+                result= counters;
+            }
+            std::sort(
+                result.begin(), result.end(),
+                [](hot_ticket const &lhs, hot_ticket const &rhs) {
+                    return lhs.count > rhs.count;
+                });
+            result.resize(std::min(k, result.size()));
+            return result;
+        }
+
+        /// Returns the estimated fraction of sampled lookups that were for
+        /// the k most frequently looked-up tickets, or 0 if there have been
+        /// none. A high share for a small k suggests a small lookup cache
+        /// would be effective.
+        double top_share(std::size_t k) const {
+            auto const hottest= top(k);
+            auto const sampled= samples();
+            std::uint64_t sum= 0;
+            for(auto const &entry : hottest) {
+                sum+= entry.count - entry.error;
+            }
+            return sampled ? static_cast<double>(sum) / sampled : 0.0;
+        }
+
+        /// Returns an estimate of the skew of the lookups, as the exponent of
+        /// the Zipf distribution that best fits the counts of the tracked
+        /// tickets: 0 for uniform lookups, around 1 for typical skewed
+        /// workloads, and more for heavier skew. Returns 0 if fewer than two
+        /// tickets have been looked up.
+        double skew() const {
+            auto const hottest= top(capacity);
+            if(hottest.size() < 2)
+                return 0.0;
+            double sum_x= 0, sum_y= 0, sum_xx= 0, sum_xy= 0;
+            auto const n= static_cast<double>(hottest.size());
+            for(std::size_t i= 0; i != hottest.size(); ++i) {
+                auto const x= std::log(static_cast<double>(i + 1));
+                auto const y= std::log(static_cast<double>(hottest[i].count));
+                sum_x+= x;
+                sum_y+= y;
+                sum_xx+= x * x;
+                sum_xy+= x * y;
+            }
+            auto const slope=
+                (n * sum_xy - sum_x * sum_y) / (n * sum_xx - sum_x * sum_x);
+            return std::max(-slope, 0.0);
+        }
+
+        /// Discard all the counts
+        void clear() noexcept {
+            lock_guard guard(busy);
+            counters.clear();
+            total= 0;
+        }
+
+    private:
+        /// Holds the busy flag for the duration of a scope, spinning until it
+        /// is clear
+        class lock_guard {
+        public:
+            explicit lock_guard(std::atomic_flag &flag_) noexcept :
+                flag(flag_) {
+                while(flag.test_and_set(std::memory_order_acquire))
+                    ;
+            }
+
+            lock_guard(lock_guard const &)= delete;
+            lock_guard &operator=(lock_guard const &)= delete;
+
+            ~lock_guard() {
+                flag.clear(std::memory_order_release);
+            }
+
+        private:
+            std::atomic_flag &flag;
+        };
+
+        /// Count a sampled lookup of ticket. The caller must hold the busy
+        /// flag.
+        void count(std::uint64_t ticket) noexcept {
+            ++total;
+            auto smallest= counters.begin();
+            for(auto it= counters.begin(); it != counters.end(); ++it) {
+                if(it->ticket == ticket) {
+                    ++it->count;
+                    return;
+                }
+                if(it->count < smallest->count)
+                    smallest= it;
+            }
+            if(counters.size() < capacity) {
+                counters.push_back({ticket, 1, 0});
+            } else {
+                *smallest= {ticket, smallest->count + 1, smallest->count};
+            }
+        }
+
+        /// The maximum number of counters
+        std::size_t capacity;
+        /// The number of lookups per sample
+        std::uint32_t sampleInterval;
+        /// The number of lookups until the next sample
+        std::atomic<std::uint32_t> countdown;
+        /// Set while the counters are in use
+        mutable std::atomic_flag busy= ATOMIC_FLAG_INIT;
+        /// The counters
+        std::vector<hot_ticket> counters;
+        /// The number of sampled lookups
+        std::uint64_t total= 0;
+    };
+
+    /// A policy that records the tickets looked up with find(), count() or
+    /// operator[] in an access_sketch, so the hottest tickets and the skew of
+    /// the lookups can be examined. Ticket must be an integral type. A
+    /// default-constructed policy records nothing.
+    template <typename Base= default_ticket_map_policy>
+    struct access_sketch_policy : Base {
+        /// Construct a policy that records nothing
+        access_sketch_policy()= default;
+
+        /// Construct a policy that records lookups in sketch_
+        explicit access_sketch_policy(
+            access_sketch &sketch_, Base base= Base()) :
+            Base(std::move(base)),
+            sketch(&sketch_) {}
+
+        /// Record lookups, and pass every operation on to the base policy
+        template <typename Ticket>
+        void
+        on_operation(ticket_map_operation op, Ticket const &ticket) const
+            noexcept {
+            static_assert(
+                std::is_integral_v<Ticket>,
+                "Only integral tickets can be sketched");
+            if(sketch && op == ticket_map_operation::find)
+                sketch->record(static_cast<std::uint64_t>(ticket));
+            Base::on_operation(op, ticket);
+        }
+
+        /// The sketch to record lookups in, if any
+        access_sketch *sketch= nullptr;
+    };
+} // namespace jss
@@ -0,0 +1,325 @@
+// This code is released under the Boost Software License
+// https://www.boost.org/LICENSE_1_0.txt
+// (C) Copyright 2021 Anthony Williams
+
+#pragma once
+
+#include "ticket_map.hpp"
+#include "latency_histogram.hpp"
+#include <cstdlib>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <random>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace jss {
+
+    /// One operation from a trace
+    struct trace_record {
+        /// The operation
+        ticket_map_operation op;
+        /// The ticket of the element operated on
+        std::uint64_t ticket;
+        /// The time of the operation, in nanoseconds since the trace started
+        std::uint64_t timestamp;
+    };
+
+    namespace detail {
+        /// The bytes at the start of every trace
+        constexpr char trace_magic[8]= {'J', 'S', 'S', 'T', 'M', 'T', 'R', 1};
+
+        /// The number of operation kinds recorded in a trace
+        constexpr std::size_t trace_operation_count= 3;
+    } // namespace detail
+
+    /// Writes a compact binary trace of ticket_map operations to a stream.
+    /// Each operation is one byte for the operation, then the difference
+    /// from the previous ticket and the time since the previous operation,
+    /// each as a variable-length integer, so typical operations take 3 or 4
+    /// bytes. Operations are buffered, and written when the buffer fills, or
+    /// when flush() is called or the writer is destroyed.
+    class trace_writer {
+    public:
+        /// Start a trace on the specified stream, writing the header
+        explicit trace_writer(std::ostream &out_) :
+            out(out_), start(std::chrono::steady_clock::now()) {
+            buffer.reserve(buffer_size);
+            out.write(detail::trace_magic, sizeof(detail::trace_magic));
+        }
+
+        trace_writer(trace_writer const &)= delete;
+        trace_writer &operator=(trace_writer const &)= delete;
+
+        /// Flush any buffered operations
+        ~trace_writer() {
+            flush();
+        }
+
+        /// Record an operation, timestamped with the current time
+        void record(
+            ticket_map_operation op, std::uint64_t ticket) noexcept {
+            auto const now= static_cast<std::uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start)
+                    .count());
+            if(buffer.size() + max_record_size > buffer_size)
+                flush();
+            buffer.push_back(static_cast<unsigned char>(op));
+            auto const delta= ticket - lastTicket;
+            write_varint((delta << 1) ^ (0 - (delta >> 63)));
+            write_varint(now - lastTime);
+            lastTicket= ticket;
+            lastTime= now;
+        }
+
+        /// Write any buffered operations to the stream. If the stream fails,
+        /// the operations are lost.
+        void flush() noexcept {
+            try {
+                out.write(
+                    reinterpret_cast<char const *>(buffer.data()),
+                    static_cast<std::streamsize>(buffer.size()));
+                out.flush();
+            } catch(...) {
+            }
+            buffer.clear();
+        }
+
+    private:
+        /// The size of the buffer
+        static constexpr std::size_t buffer_size= 65536;
+        /// The most bytes a single record can take
+        static constexpr std::size_t max_record_size= 21;
+
+        /// Append a variable-length integer to the buffer
+        void write_varint(std::uint64_t value) noexcept {
+            for(; value >= 0x80; value>>= 7) {
+                buffer.push_back(static_cast<unsigned char>(value | 0x80));
+            }
+            buffer.push_back(static_cast<unsigned char>(value));
+        }
+
+        /// The stream written to
+        std::ostream &out;
+        /// The time the trace started
+        std::chrono::steady_clock::time_point start;
+        /// The buffered operations
+        std::vector<unsigned char> buffer;
+        /// The ticket of the previous operation
+        std::uint64_t lastTicket= 0;
+        /// The timestamp of the previous operation
+        std::uint64_t lastTime= 0;
+    };
+
+    /// Reads a trace written by trace_writer from a stream
+    class trace_reader {
+    public:
+        /// Start reading a trace from the specified stream.
+        /// Throws runtime_error if the stream doesn't hold a trace.
+        explicit trace_reader(std::istream &in_) : in(in_) {
+            char magic[sizeof(detail::trace_magic)];
+            if(!in.read(magic, sizeof(magic)) ||
+               !std::equal(
+                   magic, magic + sizeof(magic), detail::trace_magic))
+                throw std::runtime_error("Not a ticket_map trace");
+        }
+
+        /// Read the next operation into record. Returns true if there was
+        /// one, or false at the end of the trace.
+        /// Throws runtime_error if the trace is corrupt.
+        bool next(trace_record &record) {
+            auto const op= in.get();
+            if(op == std::istream::traits_type::eof())
+                return false;
+            if(op >= static_cast<int>(detail::trace_operation_count))
+                throw std::runtime_error("Corrupt ticket_map trace");
+            auto const zigzag= read_varint();
+            lastTicket+= (zigzag >> 1) ^ (0 - (zigzag & 1));
+            lastTime+= read_varint();
+            record= {static_cast<ticket_map_operation>(op), lastTicket,
+                     lastTime};
+            return true;
+        }
+
+    private:
+        /// Read a variable-length integer
+        std::uint64_t read_varint() {
+            std::uint64_t value= 0;
+            for(unsigned shift= 0; shift < 64; shift+= 7) {
+                auto const byte= in.get();
+                if(byte == std::istream::traits_type::eof())
+                    throw std::runtime_error("Truncated ticket_map trace");
+                value|= std::uint64_t(byte & 0x7f) << shift;
+                if(!(byte & 0x80))
+                    return value;
+            }
+            throw std::runtime_error("Corrupt ticket_map trace");
+        }
+
+        /// The stream read from
+        std::istream &in;
+        /// The ticket of the previous operation
+        std::uint64_t lastTicket= 0;
+        /// The timestamp of the previous operation
+        std::uint64_t lastTime= 0;
+    };
+
+    /// A policy that records every operation on the map with a trace_writer.
+    /// Ticket must be an integral type. A default-constructed policy records
+    /// nothing.
+    template <typename Base= default_ticket_map_policy>
+    struct recording_policy : Base {
+        /// Construct a policy that records nothing
+        recording_policy()= default;
+
+        /// Construct a policy that records operations with writer_
+        explicit recording_policy(trace_writer &writer_, Base base= Base()) :
+            Base(std::move(base)), writer(&writer_) {}
+
+        /// Record the operation, and pass it on to the base policy
+        template <typename Ticket>
+        void
+        on_operation(ticket_map_operation op, Ticket const &ticket) const
+            noexcept {
+            static_assert(
+                std::is_integral_v<Ticket>,
+                "Only integral tickets can be recorded");
+            if(writer)
+                writer->record(op, static_cast<std::uint64_t>(ticket));
+            Base::on_operation(op, ticket);
+        }
+
+        /// The writer to record with, if any
+        trace_writer *writer= nullptr;
+    };
+
+    /// The results of replaying a trace
+    struct replay_statistics {
+        /// The latencies of each operation, in nanoseconds, indexed by
+        /// ticket_map_operation
+        std::array<latency_histogram, detail::trace_operation_count> latency;
+        /// The total time taken to replay the trace, in nanoseconds
+        std::uint64_t elapsed= 0;
+        /// The time between the first and last operation when the trace was
+        /// recorded, in nanoseconds
+        std::uint64_t recorded= 0;
+        /// The number of lookups that found an element
+        std::uint64_t found= 0;
+        /// The largest capacity of the map, in slots, during the replay
+        std::size_t peak_capacity= 0;
+
+        /// Returns the latencies for an operation
+        latency_histogram const &
+        operator[](ticket_map_operation op) const noexcept {
+            return latency[static_cast<std::size_t>(op)];
+        }
+
+        /// Returns the total number of operations replayed
+        std::uint64_t operations() const noexcept {
+            std::uint64_t total= 0;
+            for(auto const &histogram : latency) {
+                total+= histogram.count();
+            }
+            return total;
+        }
+    };
+
+    /// A description of a synthetic workload, for when there is no recorded
+    /// trace: a set of live elements that churns, with new elements inserted
+    /// and random live elements erased, and lookups of random live elements
+    struct workload_spec {
+        /// The number of live elements the workload starts churning at
+        std::size_t live= 100000;
+        /// The number of inserts and erases
+        std::size_t operations= 1000000;
+        /// The number of lookups after each insert or erase
+        std::size_t lookups= 1;
+        /// The seed for the random choices
+        std::uint64_t seed= 42;
+    };
+
+    /// Record a trace of the workload described by spec to out
+    inline void record_workload(std::ostream &out, workload_spec const &spec) {
+        trace_writer writer(out);
+        ticket_map<std::uint64_t, char, recording_policy<>> map(
+            recording_policy<>{writer});
+        std::mt19937_64 random(spec.seed);
+        std::vector<std::uint64_t> live;
+        for(std::size_t i= 0; i < spec.operations; ++i) {
+            if(live.size() <= spec.live || random() % 2) {
+                live.push_back(map.insert(0));
+            } else {
+                auto &victim= live[random() % live.size()];
+                map.erase(victim);
+                victim= live.back();
+                live.pop_back();
+            }
+            for(std::size_t j= 0; j < spec.lookups; ++j) {
+                map.find(live[random() % live.size()]);
+            }
+        }
+    }
+
+    /// Replay the trace from in against map, as fast as possible, timing each
+    /// operation. Inserts use the recorded tickets, and value-initialized
+    /// values, so the map must not already hold tickets at or beyond the
+    /// first one inserted by the trace.
+    /// Throws runtime_error if the trace is corrupt, and invalid_argument if
+    /// the map already holds tickets that the trace inserts.
+    template <typename Map>
+    replay_statistics replay_trace(std::istream &in, Map &map) {
+        using ticket_type=
+            std::remove_cv_t<std::remove_reference_t<decltype(
+                map.begin()->ticket)>>;
+        using clock= std::chrono::steady_clock;
+
+        trace_reader reader(in);
+        replay_statistics statistics;
+        trace_record record;
+        std::uint64_t first= 0;
+        bool any= false;
+        auto const start= clock::now();
+        while(reader.next(record)) {
+            auto const ticket= static_cast<ticket_type>(record.ticket);
+            auto const before= clock::now();
+            switch(record.op) {
+            case ticket_map_operation::insert:
+                map.insert_with_ticket(ticket, {});
+                break;
+            case ticket_map_operation::erase: map.erase(ticket); break;
+            case ticket_map_operation::find:
+                statistics.found+= map.find(ticket) != map.end();
+                break;
+            case ticket_map_operation::compact:
+            case ticket_map_operation::reserve:
+                // Only timed, never recorded, so trace_reader rejects them
+                continue;
+            }
+            auto const after= clock::now();
+            statistics.latency[static_cast<std::size_t>(record.op)].record(
+                static_cast<std::uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        after - before)
+                        .count()));
+            statistics.peak_capacity=
+                std::max(statistics.peak_capacity, map.capacity());
+            if(!any) {
+                first= record.timestamp;
+                any= true;
+            }
+            statistics.recorded= record.timestamp - first;
+        }
+        statistics.elapsed= static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                clock::now() - start)
+                .count());
+        return statistics;
+    }
+} // namespace jss